@@ -0,0 +1,118 @@
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <array>
+#include "corpus.h"
+
+namespace {
+
+constexpr qint64 kWriteBufferSize = 1024 * 1024;
+
+// xorshift: cheap and identical on every platform, unlike std::uniform_int_distribution
+class Random {
+public:
+    explicit Random(quint64 seed) : m_state(seed ? seed : 0x9e3779b97f4a7c15ull) {}
+
+    quint64 next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+
+    int bounded(int min, int max) {
+        return min + static_cast<int>(next() % static_cast<quint64>(max - min + 1));
+    }
+
+private:
+    quint64 m_state;
+};
+
+void appendAsciiLine(QByteArray &out, Random &random, int length) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+    for (int i = 0; i < length; ++i) {
+        out.append(alphabet[random.next() % (sizeof(alphabet) - 1)]);
+    }
+    out.append('\n');
+}
+
+void appendUtf8Line(QByteArray &out, Random &random, int length) {
+    static const std::array<const char *, 12> samples = {
+        "a", "e", " ", "\xC3\xA9",                       // é
+        "\xD0\x96", "\xD1\x8F", "\xCE\xA9",               // Ж я Ω
+        "\xE4\xB8\xAD", "\xE6\x96\x87", "\xE3\x81\x82",   // 中 文 あ
+        "\xF0\x9F\x98\x80", "\xF0\x9F\x9A\x80",           // 😀 🚀
+    };
+    for (int i = 0; i < length; ++i) {
+        out.append(samples[random.next() % samples.size()]);
+    }
+    out.append('\n');
+}
+
+}
+
+namespace Corpus {
+
+QStringList variants() {
+    return {"ascii", "utf8", "longlines", "shortlines"};
+}
+
+QString ensure(const QString &directory, const QString &variant, qint64 sizeBytes) {
+    if (!variants().contains(variant)) {
+        qWarning() << "Unknown corpus variant:" << variant;
+        return QString();
+    }
+
+    QDir().mkpath(directory);
+    const QString path = QDir(directory).filePath(QString("%1-%2.txt").arg(variant).arg(sizeBytes));
+    if (QFileInfo(path).size() == sizeBytes) {
+        return path;  // Reuse the file from an earlier run
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Could not create corpus file:" << path;
+        return QString();
+    }
+
+    Random random(qHash(variant) ^ static_cast<quint64>(sizeBytes));
+    QByteArray buffer;
+    buffer.reserve(kWriteBufferSize + 4 * 1024 * 1024);
+    qint64 written = 0;
+
+    while (written < sizeBytes) {
+        if (variant == "ascii") {
+            appendAsciiLine(buffer, random, random.bounded(40, 400));
+        } else if (variant == "utf8") {
+            appendUtf8Line(buffer, random, random.bounded(40, 200));
+        } else if (variant == "longlines") {
+            appendAsciiLine(buffer, random, random.bounded(256 * 1024, 2 * 1024 * 1024));
+        } else {
+            appendAsciiLine(buffer, random, random.bounded(0, 8));
+        }
+
+        if (buffer.size() >= kWriteBufferSize || written + buffer.size() >= sizeBytes) {
+            const qint64 remaining = sizeBytes - written;
+            if (buffer.size() > remaining) {
+                // Pad the cut-off last line with ASCII so no multi-byte sequence is split
+                buffer.truncate(remaining);
+                const qsizetype lineStart = buffer.lastIndexOf('\n') + 1;
+                buffer.replace(lineStart, buffer.size() - lineStart, QByteArray(buffer.size() - lineStart, 'x'));
+            }
+
+            const qint64 length = buffer.size();
+            if (file.write(buffer.constData(), length) != length) {
+                qWarning() << "Could not write corpus file:" << path << file.errorString();
+                file.remove();
+                return QString();
+            }
+            written += length;
+            buffer.clear();
+        }
+    }
+
+    return path;
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+// Generates the text files the benchmark loads and saves. Output is deterministic for a
+// given variant and size, so numbers from different commits are measured on the same bytes.
+namespace Corpus {
+
+// ascii: 40-400 printable ASCII characters per line (like examples/file-generator.sh)
+// utf8: Latin, Cyrillic, CJK and emoji mixed, so 1-4 byte sequences all occur
+// longlines: lines of 256 KB to 2 MB, past the editor's long-line display limit
+// shortlines: 0-8 characters per line, stressing per-line overhead
+QStringList variants();
+
+// Path of the corpus file for `variant` and `sizeBytes`, creating it under `directory`
+// if it does not exist yet. Returns an empty string on failure.
+QString ensure(const QString &directory, const QString &variant, qint64 sizeBytes);
+
+}
@@ -0,0 +1,316 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTextDocument>
+#include <QTimer>
+#include <cstdio>
+#include <functional>
+#include "codeeditor.h"
+#include "corpus.h"
+#include "document.h"
+#include "fileloaderworker.h"
+#include "largefileeditor.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// Headless load/save benchmark. The driver generates the corpora and runs every case in
+// a child process of its own, so the peak RSS reported for a case is not inflated by the
+// ones before it. Results are written as JSON for comparing runs across commits.
+
+namespace {
+
+constexpr int kTimeoutMs = 30 * 60 * 1000;
+constexpr int kFirstPaintTimeoutMs = 5000;
+
+const QStringList kCases = {"worker-load", "document-load", "document-save"};
+
+qint64 peakRssBytes() {
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize);
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(Q_OS_DARWIN)
+    return usage.ru_maxrss;  // Bytes on macOS
+#else
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;  // Kilobytes elsewhere
+#endif
+#else
+    return -1;
+#endif
+}
+
+double megabytesPerSecond(qint64 bytes, qint64 nanoseconds) {
+    if (nanoseconds <= 0) return 0.0;
+    return (bytes / (1024.0 * 1024.0)) / (nanoseconds / 1e9);
+}
+
+// Connects to `signal` before calling `start`, then spins an event loop until it fires.
+template <typename Sender, typename Signal>
+bool runUntil(Sender *sender, Signal signal, const std::function<void()> &start) {
+    QEventLoop loop;
+    QObject::connect(sender, signal, &loop, [&loop]() { loop.exit(0); });
+    QTimer::singleShot(kTimeoutMs, &loop, [&loop]() { loop.exit(1); });
+    start();
+    return loop.exec() == 0;
+}
+
+// Records the first paint of an editor viewport that already shows file content.
+class FirstPaintFilter : public QObject {
+public:
+    FirstPaintFilter(const QElapsedTimer &clock, std::function<bool()> hasContent)
+        : m_clock(clock), m_hasContent(std::move(hasContent)) {}
+
+    qint64 elapsedMs() const { return m_elapsedMs; }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override {
+        if (event->type() == QEvent::Paint && m_elapsedMs < 0 && m_hasContent()) {
+            m_elapsedMs = m_clock.elapsed();
+        }
+        return QObject::eventFilter(watched, event);
+    }
+
+private:
+    const QElapsedTimer &m_clock;
+    std::function<bool()> m_hasContent;
+    qint64 m_elapsedMs = -1;
+};
+
+// Decoding only: the worker streams chunks to a counter instead of a QTextDocument.
+QJsonObject runWorkerLoad(const QString &filePath) {
+    FileLoaderWorker worker(filePath, nullptr);
+    qint64 characters = 0;
+    QObject::connect(&worker, &FileLoaderWorker::contentLoaded, [&characters](const QString &chunk) {
+        characters += chunk.size();
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    worker.startLoading();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    const qint64 bytes = QFileInfo(filePath).size();
+    return {
+        {"seconds", elapsed / 1e9},
+        {"mbPerSecond", megabytesPerSecond(bytes, elapsed)},
+        {"characters", characters},
+    };
+}
+
+// Full open path as the editor sees it: worker thread, coalesced inserts, first paint.
+QJsonObject runDocumentLoad(const QString &filePath, Document *&document, bool &ok) {
+    QElapsedTimer timer;
+    timer.start();
+
+    document = new Document(filePath);
+    FirstPaintFilter firstPaint(timer, [document]() {
+        if (document->isLargeFile()) {
+            return document->largeEditor()->pieceTable() != nullptr;
+        }
+        return document->editor()->document()->characterCount() > 1;
+    });
+    document->editor()->viewport()->installEventFilter(&firstPaint);
+    if (document->largeEditor()) {
+        document->largeEditor()->viewport()->installEventFilter(&firstPaint);
+    }
+
+    ok = runUntil(document, &Document::loadingFinished, [document]() {
+        document->resize(1280, 800);
+        document->show();
+    });
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    // Content can finish loading before the first frame showing it has been painted
+    QElapsedTimer paintTimer;
+    paintTimer.start();
+    while (ok && firstPaint.elapsedMs() < 0 && paintTimer.elapsed() < kFirstPaintTimeoutMs) {
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    }
+
+    document->editor()->viewport()->removeEventFilter(&firstPaint);
+    if (document->largeEditor()) {
+        document->largeEditor()->viewport()->removeEventFilter(&firstPaint);
+    }
+
+    const qint64 bytes = QFileInfo(filePath).size();
+    return {
+        {"seconds", elapsed / 1e9},
+        {"mbPerSecond", megabytesPerSecond(bytes, elapsed)},
+        {"firstPaintMs", firstPaint.elapsedMs()},
+        {"largeFileMode", document->isLargeFile()},
+    };
+}
+
+// Full rewrite to a new path, so the in-place patching shortcut never applies.
+QJsonObject runDocumentSave(const QString &filePath, bool &ok) {
+    Document *document = nullptr;
+    runDocumentLoad(filePath, document, ok);
+    if (!ok) {
+        delete document;
+        return {};
+    }
+
+    const QString copyPath = filePath + ".saved";
+    QElapsedTimer timer;
+    timer.start();
+    ok = runUntil(document->worker(), &FileLoaderWorker::savingFinished, [document, &copyPath]() {
+        document->saveFileAs(copyPath);
+    });
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    const qint64 bytes = QFileInfo(copyPath).size();
+    delete document;
+    QFile::remove(copyPath);
+
+    return {
+        {"seconds", elapsed / 1e9},
+        {"mbPerSecond", megabytesPerSecond(bytes, elapsed)},
+        {"bytesWritten", bytes},
+    };
+}
+
+int runCase(const QString &caseName, const QString &filePath) {
+    QJsonObject result;
+    bool ok = true;
+
+    if (caseName == "worker-load") {
+        result = runWorkerLoad(filePath);
+    } else if (caseName == "document-load") {
+        Document *document = nullptr;
+        result = runDocumentLoad(filePath, document, ok);
+        delete document;
+    } else if (caseName == "document-save") {
+        result = runDocumentSave(filePath, ok);
+    } else {
+        fprintf(stderr, "Unknown case: %s\n", qPrintable(caseName));
+        return 2;
+    }
+
+    result.insert("case", caseName);
+    result.insert("ok", ok);
+    result.insert("peakRssBytes", peakRssBytes());
+    fprintf(stdout, "%s\n", QJsonDocument(result).toJson(QJsonDocument::Compact).constData());
+    return ok ? 0 : 1;
+}
+
+QJsonObject runChild(const QString &caseName, const QString &filePath) {
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(QCoreApplication::applicationFilePath(), {"--run-case", caseName, "--file", filePath});
+    process.waitForFinished(-1);
+
+    const QList<QByteArray> lines = process.readAllStandardOutput().trimmed().split('\n');
+    const QJsonDocument json = QJsonDocument::fromJson(lines.isEmpty() ? QByteArray() : lines.last());
+    if (!json.isObject()) {
+        return {{"case", caseName}, {"ok", false}, {"exitCode", process.exitCode()}};
+    }
+    return json.object();
+}
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &msg) {
+    // The editor logs every step with qDebug; only warnings and worse are worth keeping here
+    if (type == QtDebugMsg || type == QtInfoMsg) return;
+    fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    if (type == QtFatalMsg) abort();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");  // Headless unless a platform is forced
+    }
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("notepad_bench");
+    qInstallMessageHandler(quietMessageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures Notepad-- load and save speed on generated files.");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma separated corpus sizes in MB.", "list", "10,100,1024");
+    QCommandLineOption variantsOption("variants", "Comma separated corpus variants: " + Corpus::variants().join(", ") + ".",
+                                      "list", Corpus::variants().join(","));
+    QCommandLineOption casesOption("cases", "Comma separated cases: " + kCases.join(", ") + ".", "list", kCases.join(","));
+    QCommandLineOption corpusDirOption("corpus-dir", "Where generated files are kept between runs.", "dir",
+                                       QDir::temp().filePath("notepad-bench"));
+    QCommandLineOption outputOption("output", "JSON file to write the results to.", "file", "bench-results.json");
+    QCommandLineOption labelOption("label", "Free-form label stored with the results, e.g. a commit hash.", "text");
+    QCommandLineOption runCaseOption("run-case", "Internal: run a single case in this process.", "case");
+    QCommandLineOption fileOption("file", "Internal: corpus file for --run-case.", "file");
+    runCaseOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    fileOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    parser.addOptions({sizesOption, variantsOption, casesOption, corpusDirOption, outputOption, labelOption,
+                       runCaseOption, fileOption});
+    parser.process(app);
+
+    if (parser.isSet(runCaseOption)) {
+        return runCase(parser.value(runCaseOption), parser.value(fileOption));
+    }
+
+    QJsonArray results;
+    bool allOk = true;
+
+    for (const QString &variant : parser.value(variantsOption).split(',', Qt::SkipEmptyParts)) {
+        for (const QString &size : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+            const qint64 sizeBytes = size.trimmed().toLongLong() * 1024 * 1024;
+            fprintf(stderr, "Preparing %s corpus of %s MB...\n", qPrintable(variant), qPrintable(size.trimmed()));
+            const QString filePath = Corpus::ensure(parser.value(corpusDirOption), variant.trimmed(), sizeBytes);
+            if (filePath.isEmpty()) {
+                allOk = false;
+                continue;
+            }
+
+            for (const QString &caseName : parser.value(casesOption).split(',', Qt::SkipEmptyParts)) {
+                QJsonObject result = runChild(caseName.trimmed(), filePath);
+                result.insert("variant", variant.trimmed());
+                result.insert("sizeBytes", sizeBytes);
+                allOk = allOk && result.value("ok").toBool();
+                results.append(result);
+
+                fprintf(stderr, "  %-14s %10.1f MB/s  peak RSS %8.1f MB  first paint %6lld ms\n",
+                        qPrintable(caseName.trimmed()),
+                        result.value("mbPerSecond").toDouble(),
+                        result.value("peakRssBytes").toDouble() / (1024.0 * 1024.0),
+                        static_cast<long long>(result.value("firstPaintMs").toInteger(-1)));
+            }
+        }
+    }
+
+    const QJsonObject report{
+        {"label", parser.value(labelOption)},
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"qtVersion", QString(qVersion())},
+        {"largeFileThresholdBytes", Document::largeFileThreshold()},
+        {"results", results},
+    };
+
+    QFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fprintf(stderr, "Could not write %s\n", qPrintable(output.fileName()));
+        return 1;
+    }
+    output.write(QJsonDocument(report).toJson());
+    fprintf(stderr, "Results written to %s\n", qPrintable(output.fileName()));
+
+    return allOk ? 0 : 1;
+}
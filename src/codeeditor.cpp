@@ -5,6 +5,7 @@
 #include <QTextBlock>
 #include <QScrollBar>
 #include <QTabWidget>
+#include <algorithm>
 #include "settings.h"
 
 CodeEditor::CodeEditor(QWidget *parent, QString filePath)
@@ -28,6 +29,15 @@ CodeEditor::CodeEditor(QWidget *parent, QString filePath)
     connect(this, &CodeEditor::updateRequest, this, &CodeEditor::updateLineNumberArea);
     connect(this, &CodeEditor::cursorPositionChanged, this, &CodeEditor::highlightCurrentLine);
 
+    // Visible search matches change with scrolling; any edit invalidates the match offsets
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if (!m_searchMatches.isEmpty()) updateExtraSelections();
+    });
+    // (rehighlighting also emits contentsChange, but leaves the revision alone)
+    connect(document(), &QTextDocument::contentsChange, this, [this]() {
+        if (!m_searchMatches.isEmpty() && document()->revision() != m_searchMatchesRevision) clearSearchMatches();
+    });
+
     updateLineNumberAreaWidth(0);
     highlightCurrentLine();
 
@@ -97,6 +107,10 @@ void CodeEditor::resizeEvent(QResizeEvent *e) {
     QRect cr = contentsRect();
     lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
 
+    if (!m_searchMatches.isEmpty()) {
+        updateExtraSelections();  // More or fewer matches fit now
+    }
+
     // Force recalculation of the layout
     document()->adjustSize();
     updateGeometry();
@@ -104,6 +118,30 @@ void CodeEditor::resizeEvent(QResizeEvent *e) {
 }
 
 void CodeEditor::highlightCurrentLine() {
+    updateExtraSelections();
+    qDebug() << "Highlighted current line at position:" << textCursor().position();
+}
+
+void CodeEditor::setSearchMatches(const QVector<QPair<int, int>>& matches) {
+    m_searchMatches = matches;
+    m_searchMatchesRevision = document()->revision();
+    updateExtraSelections();
+    emit searchMatchesChanged(m_searchMatches.size());
+}
+
+void CodeEditor::clearSearchMatches() {
+    if (m_searchMatches.isEmpty()) return;
+    m_searchMatches.clear();
+    updateExtraSelections();
+    emit searchMatchesChanged(0);
+}
+
+int CodeEditor::searchMatchCount() const {
+    return m_searchMatches.size();
+}
+
+// Current line highlight plus the search matches that intersect the viewport
+void CodeEditor::updateExtraSelections() {
     QList<QTextEdit::ExtraSelection> extraSelections;
 
     if (!isReadOnly()) {
@@ -116,8 +154,28 @@ void CodeEditor::highlightCurrentLine() {
         extraSelections.append(selection);
     }
 
+    if (!m_searchMatches.isEmpty()) {
+        const int visibleStart = firstVisibleBlock().position();
+        const int visibleEnd = cursorForPosition(viewport()->rect().bottomRight()).block().next().position();
+
+        QTextCharFormat matchFormat;
+        matchFormat.setBackground(Qt::yellow);
+        matchFormat.setForeground(Qt::black);
+
+        // Matches don't overlap, so their ends are sorted too
+        auto it = std::upper_bound(m_searchMatches.cbegin(), m_searchMatches.cend(), visibleStart,
+                                   [](int position, const QPair<int, int>& match) { return position < match.second; });
+        for (; it != m_searchMatches.cend() && (visibleEnd <= 0 || it->first < visibleEnd); ++it) {
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(document());
+            selection.cursor.setPosition(it->first);
+            selection.cursor.setPosition(it->second, QTextCursor::KeepAnchor);
+            selection.format = matchFormat;
+            extraSelections.append(selection);
+        }
+    }
+
     setExtraSelections(extraSelections);
-    qDebug() << "Highlighted current line at position:" << textCursor().position();
 }
 
 void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
@@ -231,9 +289,13 @@ void CodeEditor::goToLineInText(int lineNumber) {
 void CodeEditor::gotoLineInEditor(int lineNumber) {
     // Ensure the line number is within the valid range
     if (lineNumber > 0 && lineNumber <= blockCount()) {
-        QTextCursor cursor = textCursor();
-        cursor.movePosition(QTextCursor::Start);
-        cursor.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor, lineNumber - 1);
+        // Look the visual line up in the block map instead of stepping down line by line
+        QTextBlock block = document()->findBlockByLineNumber(lineNumber - 1);
+        QTextCursor cursor(block);
+        const int lineInBlock = lineNumber - 1 - block.firstLineNumber();
+        if (lineInBlock > 0 && block.layout() && lineInBlock < block.layout()->lineCount()) {
+            cursor.setPosition(block.position() + block.layout()->lineAt(lineInBlock).textStart());
+        }
         setTextCursor(cursor);
         centerCursor();
     } else {
@@ -430,24 +492,30 @@ void CodeEditor::paintEvent(QPaintEvent* event) {
     QPainter painter(viewport());
     painter.setPen(Qt::gray);
 
-    QTextBlock block = document()->firstBlock();
+    // Only blocks inside the viewport are painted; walking the whole document
+    // here made every repaint O(number of lines).
+    const QTextBlock firstBlock = firstVisibleBlock();
+    const int viewportBottom = viewport()->rect().bottom();
+    QTextBlock block = firstBlock;
     QFontMetrics metrics(font());
 
     // Draw indent guides if enabled
     if (m_showIndentGuide) {
         while (block.isValid()) {
+            QRect blockRect = blockBoundingGeometry(block).translated(contentOffset()).toRect();
+            if (blockRect.top() > viewportBottom) break;
             if (block.isVisible()) {
-                QRect blockRect = blockBoundingGeometry(block).translated(contentOffset()).toRect();
                 paintIndentGuides(painter, block, blockRect.top(), blockRect.bottom());
             }
             block = block.next();
         }
-        block = document()->firstBlock();  // Reset block for next drawing loop
+        block = firstBlock;  // Reset block for next drawing loop
     }
 
     // Handle Tabs, Spaces, EOL, and Wrap Symbols
     while (block.isValid()) {
         QRect blockRect = blockBoundingGeometry(block).translated(contentOffset()).toRect();
+        if (blockRect.top() > viewportBottom) break;
 
         if (block.isVisible()) {
             // Draw Tabs
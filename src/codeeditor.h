@@ -1,6 +1,8 @@
 #pragma once
 
 #include <QPlainTextEdit>
+#include <QPair>
+#include <QVector>
 
 class QPaintEvent;
 class QResizeEvent;
@@ -22,6 +24,12 @@ public:
     void applyIndentation(bool useTabs, int indentationWidth);
     QTabWidget* DocumentsTab();
     void highlightAllOccurrences(const QString& keyword);
+
+    // Search matches as sorted (start, end) positions. Only those inside the viewport
+    // become ExtraSelections, so the document's formats and undo stack stay untouched.
+    void setSearchMatches(const QVector<QPair<int, int>>& matches);
+    void clearSearchMatches();
+    int searchMatchCount() const;
     void goToLineInText(int lineNumber);
     void gotoLineInEditor(int lineNumber);
     void setShowTabs(bool enabled);
@@ -44,6 +52,7 @@ protected:
 
 signals:
     void textChanged(); // FIXME: Remove this line.
+    void searchMatchesChanged(int count);
 
 private slots:
     void updateLineNumberAreaWidth(int newBlockCount);
@@ -63,7 +72,10 @@ private:
     int m_tabWidth;
     bool m_showMathRendering = false;
     QString m_filePath;
+    QVector<QPair<int, int>> m_searchMatches;
+    int m_searchMatchesRevision = -1;
 
+    void updateExtraSelections();
     void paintTabs(QPainter& painter, const QTextBlock& block, int top);
     void paintSpaces(QPainter& painter, const QTextBlock& block, int top);
     void paintEOL(QPainter& painter, const QTextBlock& block, int top, int bottom);
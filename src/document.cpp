@@ -14,10 +14,15 @@
 #include <QtConcurrent>
 #include <QtConcurrent/QtConcurrent>
 #include <QFileInfo>
+#include <QPointer>
+#include <QTextBlock>
 #include "helpers.h"
 #include "document.h"
 #include "fileloaderworker.h"
 #include "codeeditor.h"
+#include "largefileeditor.h"
+#include "piecetable.h"
+#include "settings.h"
 #include "languages/languagemanager.h"
 
 Document::Document(const QString &filePath, QWidget *parent)
@@ -46,18 +51,58 @@ Document::Document(const QString &filePath, QWidget *parent)
     m_fileLoaderWorker = new FileLoaderWorker(m_filePath, this);
     m_fileLoaderWorker->moveToThread(m_workerThread);
 
+    // Files above the threshold are stored in a piece table over the mapped file
+    if (!m_filePath.isEmpty() && fileInfo.size() >= largeFileThreshold()) {
+        qDebug() << "Large file detected, using piece table storage for:" << m_filePath;
+        m_pieceTable = std::make_shared<PieceTable>();
+        m_fileLoaderWorker->setPieceTable(m_pieceTable.get());
+
+        // The piece table is shown through the virtualized view instead of the QTextDocument
+        m_largeEditor = new LargeFileEditor(this);
+        layout->insertWidget(0, m_largeEditor);
+        m_editor->setReadOnly(true);
+        m_editor->hide();
+
+        connect(m_largeEditor, &LargeFileEditor::textChanged, this, [this]() {
+            m_remapAfterSave = false;  // The saved file no longer matches the table
+            if (!m_isLoading) {
+                this->setModified(true);
+            }
+        });
+    }
+
+    // Progress is read from the worker's atomic counter rather than signalled per step
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(50);
+    connect(m_progressTimer, &QTimer::timeout, this, &Document::pollWorkerProgress);
+
     connect(m_fileLoaderWorker, &FileLoaderWorker::loadingStarted, this, &Document::onLoadingStarted, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::errorOccurred, this, &Document::onLoadingError, Qt::QueuedConnection);
+    connect(m_fileLoaderWorker, &FileLoaderWorker::loadingError, this, &Document::onLoadingError, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::contentLoaded, this, &Document::onContentLoaded, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::fileSizeDetermined, this, &Document::onFileSizeDetermined, Qt::QueuedConnection);
+    connect(m_fileLoaderWorker, &FileLoaderWorker::plainUtf8Determined, this, [this](bool plainUtf8) {
+        m_plainUtf8File = plainUtf8;
+    }, Qt::QueuedConnection);
+    connect(m_editor->document(), &QTextDocument::contentsChange, this, &Document::trackChanges);
+    connect(m_fileLoaderWorker, &FileLoaderWorker::contentHashDetermined, this,
+            [this](const QString &filePath, const QByteArray &hash, qint64 length) {
+        if (filePath == m_filePath) {
+            m_contentHash = hash;
+            m_contentLength = length;
+        }
+    }, Qt::QueuedConnection);
+
+    // Typing back to the saved text clears the modified flag again
+    m_modificationCheckTimer = new QTimer(this);
+    m_modificationCheckTimer->setSingleShot(true);
+    m_modificationCheckTimer->setInterval(300);
+    connect(m_modificationCheckTimer, &QTimer::timeout, this, &Document::checkModifiedInBackground);
     connect(m_fileLoaderWorker, &FileLoaderWorker::savingStarted, this, &Document::onSavingStarted, Qt::QueuedConnection);
-    connect(m_fileLoaderWorker, &FileLoaderWorker::savingProgress, this, &Document::onSavingProgress, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::savingFinished, this, &Document::onSavingFinished, Qt::QueuedConnection);
-    connect(m_fileLoaderWorker, &FileLoaderWorker::loadingProgress, this, &Document::onLoadingProgress, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::loadingFinished, this, &Document::onLoadingFinished, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::loadingFinished, this, &Document::handleProgressBarHiding, Qt::QueuedConnection);
     connect(m_fileLoaderWorker, &FileLoaderWorker::savingFinished, this, &Document::onSavingFinished, Qt::QueuedConnection);
-    connect(this, &Document::savingProgress, m_progressBar, &QProgressBar::setValue, Qt::QueuedConnection);
     connect(this, &Document::uiReady, m_fileLoaderWorker, &FileLoaderWorker::startLoading);
     connect(m_fileLoaderWorker, &FileLoaderWorker::loadingFinished, this, &Document::handleProgressBarHiding);
     // Connect the editor's textChanged signal, but ensure changes are only registered after loading is complete
@@ -65,6 +110,7 @@ Document::Document(const QString &filePath, QWidget *parent)
         if (!m_isLoading) {
             qDebug() << "Text changed for document: " << m_filePath << ", setting modified flag.";
             this->setModified(true);
+            m_modificationCheckTimer->start();
         }
     });
     connect(m_editor, &QPlainTextEdit::cursorPositionChanged, this, [this]() {
@@ -79,6 +125,7 @@ Document::Document(const QString &filePath, QWidget *parent)
     // Use QTimer::singleShot to emit uiReady signal after a delay
     QTimer::singleShot(100, this, [this]() {
         qDebug() << "Emitting uiReady signal after ensuring UI is ready...";
+        m_isLoading = true;  // Set now, not on loadingStarted; the worker starts filling at once
         emit uiReady();
     });
 
@@ -94,6 +141,9 @@ Document::~Document() {
 
     if (m_workerThread) {
         if (m_workerThread->isRunning()) {
+            // Abort a load in progress, but let queued saves finish: quit() would drop them
+            m_fileLoaderWorker->cancel();
+            QMetaObject::invokeMethod(m_fileLoaderWorker, []() {}, Qt::BlockingQueuedConnection);
             qDebug() << "Stopping worker thread";
             m_workerThread->quit();  // Gracefully stop the worker thread
             m_workerThread->wait();  // Ensure the thread finishes its work
@@ -111,6 +161,11 @@ Document::~Document() {
     qDebug() << "Document destructor called, all resources cleaned up.";
 }
 
+qint64 Document::largeFileThreshold() {
+    qint64 megabytes = Settings::instance()->loadSetting("Editor", "LargeFileThresholdMB", "128").toLongLong();
+    return qMax<qint64>(1, megabytes) * 1024 * 1024;
+}
+
 QString Document::filePath() const {
     return m_filePath;
 }
@@ -123,11 +178,20 @@ void Document::onLoadingStarted() {
     m_totalBytesRead = 0;
     m_lastSmoothedProgress = 0;
 
+    // Build the document without repainting or recording undo steps; chunks are
+    // collected in m_pendingContent and appended a few megabytes at a time.
+    m_isLoading = true;
+    m_pendingContent.clear();
+    m_loadTimer.start();
+    m_editor->setUpdatesEnabled(false);
+    m_editor->document()->setUndoRedoEnabled(false);
+
     // Set the label text and make widgets visible
     m_statusLabel->setText("Loading File...");
     m_statusLabel->setVisible(true);
     m_progressBar->setValue(0);
     m_progressBar->setVisible(true);
+    m_progressTimer->start();
 }
 
 void Document::onSavingStarted() {
@@ -137,28 +201,17 @@ void Document::onSavingStarted() {
     m_statusLabel->setVisible(true);
     m_progressBar->setValue(0);
     m_progressBar->setVisible(true);
+    m_progressTimer->start();
 }
 
-void Document::onLoadingProgress(int progress) {
-    if (progress >= 0 && progress <= 100) {
-        m_progressBar->setValue(progress);
-        qDebug() << "Progress updated to:" << progress << "%";
-    }
-
-    if (progress == 100) {
-        qDebug() << "File loading complete.";
-        onLoadingFinished();  // Trigger finished logic
-    }
-}
-
-void Document::onSavingProgress(int progress) {
-    qDebug() << "Saving progress updated:" << progress;
+void Document::pollWorkerProgress() {
+    const int progress = m_fileLoaderWorker->progress();
     m_progressBar->setValue(progress);
 
-    if (progress == 100) {
-        qDebug() << "File saving complete.";
-        onSavingFinished();
-        emit hideProgressBar();
+    if (m_isSaving) {
+        emit savingProgress(progress);
+    } else {
+        emit loadingProgress(progress);
     }
 }
 
@@ -170,24 +223,35 @@ void Document::handleProgressBarHiding() {
 }
 
 void Document::onLoadingFinished() {
-    if (m_progressBar->value() < 100) {
-        // Simulate smooth completion if it finishes too fast
-        for (int i = m_progressBar->value(); i <= 100; ++i) {
-            QThread::msleep(10);  // Gradually update progress to 100%
-            m_progressBar->setValue(i);
-            QCoreApplication::processEvents();
-        }
-    }
+    m_progressTimer->stop();
+    finishContentLoading();
 
     qDebug() << "Loading finished for document:" << m_filePath;
 
+    if (m_largeEditor && m_largeEditor->pieceTable() != m_pieceTable.get()) {
+        m_largeEditor->setPieceTable(m_pieceTable.get());
+    }
+
     m_progressBar->setVisible(false);  // Hide the progress bar
     m_statusLabel->setVisible(false);  // Hide the status label
 }
 
 void Document::onSavingFinished() {
     qDebug() << "Saving finished for document:" << m_filePath;
+    m_progressTimer->stop();
     m_isSaving = false;
+
+    // New baseline for the next incremental save
+    QFileInfo savedFile(m_filePath);
+    m_savedFileSize = savedFile.size();
+    m_savedFileModified = savedFile.lastModified();
+
+    // The saved file holds exactly the table's text unless it was edited during the save
+    if (m_remapAfterSave && m_pieceTable && m_pieceTable->load(m_filePath)) {
+        m_largeEditor->viewport()->update();
+    }
+    m_remapAfterSave = false;
+
     m_statusLabel->clear();
     m_statusLabel->setVisible(false);
     m_progressBar->setVisible(false);
@@ -195,6 +259,11 @@ void Document::onSavingFinished() {
 
 void Document::onLoadingError(const QString &error) {
     qDebug() << "Error loading document:" << m_filePath << " Error:" << error;
+    m_progressTimer->stop();
+    m_isSaving = false;
+    m_remapAfterSave = false;
+    m_plainUtf8File = false;  // After a failed write only a full save can be trusted
+    finishContentLoading();
     m_statusLabel->setText("Error: " + error);
 }
 
@@ -250,13 +319,13 @@ void Document::finishLoading() {
 }
 
 void Document::saveFile() {
+    if (rejectWhileLoading()) return;
     if (!m_fileLoaderWorker) {
         qDebug() << "No file loader worker initialized. Cannot save file.";
         return;
     }
 
     QString filePath = m_filePath;
-    QString currentText = m_editor->toPlainText();
 
     if (filePath.isEmpty()) {
         qDebug() << "File path is empty. Save operation aborted.";
@@ -271,7 +340,7 @@ void Document::saveFile() {
 
     // Start the save operation in the worker thread
     m_isSaving = true;
-    m_fileLoaderWorker->saveFile(filePath, currentText);
+    startSave(filePath);
     m_isModified = false;
     m_editor->document()->setModified(false);
     qDebug() << "Save operation started for file:" << filePath;
@@ -293,13 +362,12 @@ void Document::saveAcopyAs() {
     if (filePath.isEmpty())
         return;
 
+    if (rejectWhileLoading()) return;
     if (!m_fileLoaderWorker) {
         qDebug() << "No file loader worker initialized. Cannot save file.";
         return;
     }
 
-    QString currentText = m_editor->toPlainText();
-
     // Reset progress bar and show it
     m_progressBar->setValue(0);
     m_progressBar->setVisible(true);
@@ -307,17 +375,100 @@ void Document::saveAcopyAs() {
 
     // Start the save operation in the worker thread
     m_isSaving = true;
-    //m_fileLoaderWorker->saveFile(filePath, currentText);
-
-    QFuture<void> future = QtConcurrent::run([this, filePath, currentText]() {
-        m_fileLoaderWorker->saveFile(filePath, currentText);
-    });
+    startSave(filePath);
 
     m_isModified = false;
     m_editor->document()->setModified(false);
     qDebug() << "Save operation started for file:" << filePath;
 }
 
+// The worker thread is still filling the piece table (or the editor), so there is nothing
+// consistent to copy for a save yet
+bool Document::rejectWhileLoading() {
+    if (!m_isLoading) return false;
+
+    QMessageBox::information(this, "Information", "The file is still loading. Save it once loading has finished.");
+    return true;
+}
+
+// Queues the save on the worker thread. The worker gets its own copy of the content
+// (a piece table snapshot shares the file mapping and append buffer), so the user can
+// keep editing while it is written.
+void Document::startSave(const QString &filePath) {
+    QPointer<FileLoaderWorker> worker(m_fileLoaderWorker);
+
+    if (m_pieceTable) {
+#ifdef Q_OS_WIN
+        // Windows cannot replace a mapped file, so the table keeps the text in memory until
+        // the save is done, then maps the saved file again (see onSavingFinished)
+        const QString mapped = m_pieceTable->mappedFile();
+        if (!mapped.isEmpty() && QFileInfo(mapped) == QFileInfo(filePath)) {
+            m_pieceTable->detachFile();
+            m_remapAfterSave = true;
+        }
+#endif
+        auto snapshot = std::make_shared<const PieceTable>(*m_pieceTable);
+        QMetaObject::invokeMethod(m_fileLoaderWorker, [worker, filePath, snapshot]() {
+            if (worker) worker->savePieceTable(filePath, snapshot);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    QString content = m_editor->toPlainText();
+
+    // Patch the file in place when it is still exactly what was loaded or last saved
+    QFileInfo target(filePath);
+    const bool patchable = filePath == m_filePath && m_plainUtf8File && m_firstChanged >= 0
+                           && target.size() == m_savedFileSize && target.lastModified() == m_savedFileModified;
+    const qsizetype firstChanged = m_firstChanged;
+    const qsizetype unchangedTail = m_unchangedTail;
+    const qint64 fileSize = m_savedFileSize;
+
+    if (filePath == m_filePath) {
+        // The saved content becomes the new baseline; later edits are tracked against it.
+        // Saving through QSaveFile writes a BOM-less UTF-8 file, CRLF only on Windows.
+#ifdef Q_OS_WIN
+        m_plainUtf8File = patchable;
+#else
+        m_plainUtf8File = patchable || (!content.contains(QLatin1Char('\r')) && !content.startsWith(QChar::ByteOrderMark));
+#endif
+        resetChangeTracking();
+    }
+
+    if (patchable) {
+        QMetaObject::invokeMethod(m_fileLoaderWorker, [worker, filePath, content, firstChanged, unchangedTail, fileSize]() {
+            if (worker) worker->saveChanges(filePath, content, firstChanged, unchangedTail, fileSize);
+        }, Qt::QueuedConnection);
+    } else {
+        QMetaObject::invokeMethod(m_fileLoaderWorker, [worker, filePath, content]() {
+            if (worker) worker->saveFile(filePath, content);
+        }, Qt::QueuedConnection);
+    }
+}
+
+// Widens the edited span to cover a change reported by QTextDocument::contentsChange.
+// Format-only updates (syntax highlighting) are reported too; they only make the span
+// wider, and saveChanges() narrows it again against the file.
+void Document::trackChanges(int position, int charsRemoved, int charsAdded) {
+    if (m_isLoading || m_pieceTable || (charsRemoved == 0 && charsAdded == 0)) return;
+
+    const qsizetype length = m_editor->document()->characterCount() - 1;  // Without the final paragraph separator
+    const qsizetype tail = qMax<qsizetype>(0, length - (position + charsAdded));
+
+    if (m_firstChanged < 0) {
+        m_firstChanged = position;
+        m_unchangedTail = tail;
+    } else {
+        m_firstChanged = qMin<qsizetype>(m_firstChanged, position);
+        m_unchangedTail = qMin(m_unchangedTail, tail);
+    }
+}
+
+void Document::resetChangeTracking() {
+    m_firstChanged = -1;
+    m_unchangedTail = 0;
+}
+
 bool Document::closeDocument() {
     qDebug() << "Checking document close: isLoading=" << m_isLoading << ", isSaving=" << m_isSaving;
 
@@ -327,6 +478,10 @@ bool Document::closeDocument() {
         return false;
     }
 
+    // Don't prompt when the edits have been undone back to the saved text
+    m_modificationCheckTimer->stop();
+    refreshModifiedFromContent();
+
     if (isModified()) {
         // Document has unsaved changes, so prompt the user
         QMessageBox::StandardButton reply;
@@ -391,21 +546,13 @@ void Document::goToLineNumberInEditor() {
                                           tr("Line number:"), 1, 1, INT_MAX, 1, &ok);
 
     if (ok) {
-        QTextCursor cursor = m_editor->textCursor();
-        cursor.movePosition(QTextCursor::Start);
-
-        for (int i = 1; i < lineNumber; ++i) {
-            cursor.movePosition(QTextCursor::Down);
-
-            if (cursor.atEnd()) {
-                QMessageBox::warning(this, tr("Line Number Out of Bounds"),
-                                     tr("The specified line number is outside the bounds of the file."));
-                return;
-            }
+        if (lineNumber > lineCount()) {
+            QMessageBox::warning(this, tr("Line Number Out of Bounds"),
+                                 tr("The specified line number is outside the bounds of the file."));
+            return;
         }
 
-        m_editor->setTextCursor(cursor);
-        m_editor->ensureCursorVisible();
+        goToLine(lineNumber);
         qDebug() << "Moved to line number:" << lineNumber;
     } else {
         qDebug() << "User canceled the line number input.";
@@ -417,23 +564,36 @@ void Document::goToLineNumberInText(QWidget* parent) {
     int lineNumber = QInputDialog::getInt(parent, tr("Go to Line"),
                                           tr("Line number:"), 1, 1, INT_MAX, 1, &ok);
     if (ok) {
-        QTextCursor cursor = m_editor->textCursor();
-        cursor.movePosition(QTextCursor::Start);
-
-        int currentLineNumber = 0;
-        while (currentLineNumber < lineNumber - 1 && !cursor.atEnd()) {
-            cursor.movePosition(QTextCursor::NextBlock);
-            ++currentLineNumber;
-        }
-
-        m_editor->setTextCursor(cursor);
-        m_editor->ensureCursorVisible();
+        goToLine(qMin<qint64>(lineNumber, lineCount()));
         qDebug() << "Moved to line number:" << lineNumber;
     } else {
         qDebug() << "User canceled the line number input.";
     }
 }
 
+// Jumps straight to a 1-based line: the piece table's line index for large files,
+// the QTextDocument block map otherwise. Neither walks the lines in between.
+void Document::goToLine(qint64 lineNumber) {
+    if (m_largeEditor) {
+        m_largeEditor->gotoLine(lineNumber);
+        return;
+    }
+
+    QTextBlock block = m_editor->document()->findBlockByNumber(static_cast<int>(lineNumber - 1));
+    if (!block.isValid()) return;
+
+    m_editor->setTextCursor(QTextCursor(block));
+    m_editor->centerCursor();
+}
+
+qint64 Document::lineCount() const {
+    if (m_pieceTable) {
+        // The worker thread is still building the line index; the table is read once it is done
+        return m_isLoading ? 1 : m_pieceTable->lineCount();
+    }
+    return m_editor->blockCount();
+}
+
 void Document::applySyntaxHighlighter(const QString &language) {
     qDebug() << "Applying syntax highlighter for language: " << language;
     m_language = language;
@@ -458,24 +618,60 @@ bool Document::compareText(const QString &text1, const QString &text2) {
     qDebug() << "text1 (loaded from editor) length: " << text1.length();
     qDebug() << "text2 (from file) length: " << text2.length();
 
-    // First compare lengths
-    if (text1.length() != text2.length()) {
-        qDebug() << "text1 and text2 are different in length";
-        return false;
+    // QString::operator== checks the lengths first, then compares the buffers in bulk
+    return text1 == text2;
+}
+
+QByteArray Document::calculateMD5(const QString& text) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    FileLoaderWorker::addPlainText(hash, text);
+    return hash.result();
+}
+
+// Only texts with the saved character count are worth hashing, so most checks cost nothing
+bool Document::mayMatchSavedContent() const {
+    if (m_pieceTable || m_isLoading || !m_isModified || m_contentHash.isEmpty()) return false;
+
+    const qint64 length = m_editor->document()->characterCount() - 1;  // Without the final paragraph separator
+    return length == m_contentLength;
+}
+
+void Document::markContentUnmodified() {
+    qDebug() << "Editor text matches the saved content again:" << m_filePath;
+    setModified(false);
+    m_editor->document()->setModified(false);
+}
+
+// Compares the editor text with the hash taken while loading or saving, right away;
+// closing needs the answer before it decides whether to prompt
+void Document::refreshModifiedFromContent() {
+    if (mayMatchSavedContent() && calculateMD5(m_editor->toPlainText()) == m_contentHash) {
+        markContentUnmodified();
     }
+}
 
-    // Then compare character by character
-    for (int i = 0; i < text1.length(); ++i) {
-        if (text1[i] != text2[i]) {
-            qDebug() << "text1 and text2 are different in content at position:" << i;
-            return false;
-        }
+// The same check while typing. The snapshot is hashed on the thread pool, as saving
+// writes it there, and the result is dropped if the text was edited meanwhile.
+void Document::checkModifiedInBackground() {
+    if (!mayMatchSavedContent()) return;
+    if (m_modificationCheck.isRunning()) {
+        m_modificationCheckTimer->start();  // One hash at a time; look again once it is done
+        return;
     }
 
-    return true;
+    const int revision = m_editor->document()->revision();
+    const QByteArray savedHash = m_contentHash;
+    m_modificationCheck = QtConcurrent::run(&Document::calculateMD5, m_editor->toPlainText());
+    m_modificationCheck.then(this, [this, revision, savedHash](const QByteArray& hash) {
+        if (m_editor->document()->revision() != revision || savedHash != m_contentHash) return;
+        if (m_isModified && hash == m_contentHash) {
+            markContentUnmodified();
+        }
+    });
 }
 
 void Document::saveDocument() {
+    if (rejectWhileLoading()) return;
     QString filePath = m_filePath;  // Get the file path
 
     if (filePath.isEmpty()) {
@@ -483,10 +679,8 @@ void Document::saveDocument() {
         return;
     }
 
-    QString fileContent = m_editor->toPlainText();  // Get the current content from the editor
-
     // Call the worker to save the file content
-    m_fileLoaderWorker->saveFile(filePath, fileContent);
+    startSave(filePath);
     m_editor->document()->setModified(false);
 }
 
@@ -501,20 +695,50 @@ void Document::onContentLoaded(const QString &chunk) {
         return;
     }
 
-    // Block signals during content loading
+    m_pendingContent.append(chunk);
+    m_totalBytesRead += chunk.size();
+
+    if (m_pendingContent.size() >= kLoadFlushSize) {
+        flushPendingContent();
+    }
+}
+
+// Appends the collected chunks at the end of the document as a single edit.
+void Document::flushPendingContent() {
+    if (m_pendingContent.isEmpty()) return;
+
+    QTextCursor cursor(m_editor->document());
+    cursor.movePosition(QTextCursor::End);
+
     m_editor->blockSignals(true);
-    m_editor->insertPlainText(chunk);
+    cursor.beginEditBlock();
+    cursor.insertText(m_pendingContent);
+    cursor.endEditBlock();
     m_editor->blockSignals(false);
 
-    m_totalBytesRead += chunk.size();
+    m_pendingContent.clear();
+}
 
-    // Check if loading is complete
-    if (m_totalBytesRead >= m_fileSize) {
-        qDebug() << "Document loading finished for: " << m_filePath;
-        m_isLoading = false;  // Mark loading as complete
-        setModified(false);  // Reset the modified flag
-        emit loadingFinished();
-    }
+// Attaches the loaded text to the editor once the worker is done (or has failed).
+void Document::finishContentLoading() {
+    if (!m_isLoading) return;
+
+    flushPendingContent();
+    m_pendingContent.squeeze();
+
+    m_editor->document()->setUndoRedoEnabled(true);
+    m_editor->setUpdatesEnabled(true);
+    m_editor->moveCursor(QTextCursor::Start);
+
+    m_isLoading = false;
+    setModified(false);
+    resetChangeTracking();
+
+    QFileInfo loadedFile(m_filePath);
+    m_savedFileSize = loadedFile.size();
+    m_savedFileModified = loadedFile.lastModified();
+    qInfo() << "Loaded" << m_filePath << "(" << m_totalBytesRead << "characters ) in" << m_loadTimer.elapsed() << "ms";
+    emit loadingFinished();
 }
 
 bool Document::isLoading() const {
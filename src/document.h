@@ -7,12 +7,19 @@
 #include <QMap>
 #include <QLabel>
 #include <QProgressBar>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDateTime>
+#include <QFuture>
 #include <QSyntaxHighlighter>
+#include <memory>
 #include "fileloaderworker.h"
 
 class CodeEditor;
+class LargeFileEditor;
 class FileLoaderWorker;
 class LanguageManager;
+class PieceTable;
 
 class Document : public QWidget {
     Q_OBJECT
@@ -36,6 +43,8 @@ public:
     bool closeDocument();
     void goToLineNumberInText(QWidget* parent);
     void goToLineNumberInEditor();
+    void goToLine(qint64 lineNumber);
+    qint64 lineCount() const;
     void applySyntaxHighlighter(const QString &language);
     QString getEditorContent() const;
     bool compareText(const QString &text1, const QString &text2);
@@ -44,9 +53,12 @@ public:
     void startLoading();
     void finishLoading();
     CodeEditor* editor() const { return m_editor; }
+    LargeFileEditor* largeEditor() const { return m_largeEditor; }
     FileLoaderWorker* worker() const { return m_fileLoaderWorker; }
     bool isLoading() const;
-    QString originalFileContent;
+    bool isLargeFile() const { return m_pieceTable != nullptr; }
+    PieceTable* pieceTable() const { return m_pieceTable.get(); }
+    static qint64 largeFileThreshold();
     int savedCursorPosition() const;
     void setSavedCursorPosition(int position);
     QThread* workerThread() const;
@@ -66,7 +78,6 @@ signals:
 
 public slots:
     void onLoadingStarted();
-    void onLoadingProgress(int progress);
     void onLoadingFinished();
     void onLoadingError(const QString &error);
     void onSavingStarted();
@@ -75,22 +86,32 @@ public slots:
 private slots:
     void onContentLoaded(const QString &chunk);
     void onFileSizeDetermined(qint64 fileSize);
-    void onSavingProgress(int progress);
+    void pollWorkerProgress();
     void onSavingFinished();
 
 private:
     void loadContent();
     void loadContentAsync();
-    void trackChanges();
+    void trackChanges(int position, int charsRemoved, int charsAdded);
+    void resetChangeTracking();
     void loadEntireFile();
-    void mirrorChangesToMemory(qint64 segmentStart, const QString &text);
-    QString calculateMD5Stream(QFile *file);
-    QString calculateModifiedMD5();
+    void flushPendingContent();
+    bool rejectWhileLoading();
+    void startSave(const QString &filePath);
+    void finishContentLoading();
+    static QByteArray calculateMD5(const QString& text);
+    bool mayMatchSavedContent() const;
+    void markContentUnmodified();
+    void refreshModifiedFromContent();
+    void checkModifiedInBackground();
 
-    bool m_isLoading;
-    QString m_bufferedContent;
+    bool m_isLoading = false;
     bool m_isSaving = false;
     qint64 m_totalBytesRead;
+    QString m_pendingContent;
+    QElapsedTimer m_loadTimer;
+    QTimer *m_progressTimer;
+    static constexpr qsizetype kLoadFlushSize = 4 * 1024 * 1024; // Characters appended per edit
     QThread *m_workerThread;
     FileLoaderWorker *m_fileLoaderWorker;
     QLabel *m_statusLabel;
@@ -101,10 +122,26 @@ private:
     QString m_fileExtension;
     QFile m_file;
     CodeEditor *m_editor;
+    LargeFileEditor *m_largeEditor = nullptr;
     std::unique_ptr<QSyntaxHighlighter> syntaxHighlighter;
     qint64 m_fileSize;
-    QMap<qint64, QString> m_changedSegments;
-    QString m_currentText;
+
+    // Edited span since the last load/save, used to patch the file in place on save.
+    // Everything before m_firstChanged and the last m_unchangedTail characters still
+    // match the file, which holds m_savedFileSize bytes as of m_savedFileModified.
+    qsizetype m_firstChanged = -1;
+    qsizetype m_unchangedTail = 0;
+    bool m_plainUtf8File = false;
+    bool m_remapAfterSave = false;   // The piece table let go of its file for a save (Windows)
+    qint64 m_savedFileSize = -1;
+    QDateTime m_savedFileModified;
+
+    // Hash and length of the text as last loaded or saved (see FileLoaderWorker::addPlainText)
+    QByteArray m_contentHash;
+    qint64 m_contentLength = -1;
+    QTimer *m_modificationCheckTimer;
+    QFuture<QByteArray> m_modificationCheck;
+    std::shared_ptr<PieceTable> m_pieceTable;
     QString m_language;
     int m_lastProgress = 0;
     int m_lastSmoothedProgress = 0;
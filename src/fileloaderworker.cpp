@@ -1,10 +1,16 @@
 #include "fileloaderworker.h"
 #include "document.h"
-#include <QApplication>
+#include "piecetable.h"
 #include <QMetaObject>
 #include <QThread>
 #include <QDebug>
 #include <QFile>
+#include <QSaveFile>
+#include <QStringDecoder>
+#include <QStringEncoder>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
 
 FileLoaderWorker::FileLoaderWorker(const QString &filePath, Document *doc, QObject *parent)
     : QObject(parent), m_file(filePath), m_filePath(filePath), document(doc) {
@@ -19,6 +25,22 @@ FileLoaderWorker::~FileLoaderWorker() {
     }
 }
 
+void FileLoaderWorker::setPieceTable(PieceTable *pieceTable) {
+    m_pieceTable = pieceTable;
+}
+
+int FileLoaderWorker::progress() const {
+    return m_progress.load(std::memory_order_relaxed);
+}
+
+void FileLoaderWorker::cancel() {
+    m_cancelled.store(true, std::memory_order_relaxed);
+}
+
+void FileLoaderWorker::setProgress(qint64 done, qint64 total) {
+    m_progress.store(total > 0 ? static_cast<int>((done * 100) / total) : 100, std::memory_order_relaxed);
+}
+
 qint64 calculateChunkSize(qint64 fileSize) {
     qint64 chunkSize = fileSize / 100;
 
@@ -42,83 +64,349 @@ void FileLoaderWorker::startLoading() {
     }
 
     m_fileSize = file.size();
+    m_progress.store(0, std::memory_order_relaxed);
     emit fileSizeDetermined(m_fileSize);
     emit loadingStarted();  // Ensure UI knows loading has started
 
-    const qint64 chunkSize = 16 * 1024;  // Use 16KB chunks for finer updates
+    // Large files are kept in the piece table and shown by LargeFileEditor, which
+    // decodes only the visible lines, so nothing is streamed into the QTextDocument.
+    if (m_pieceTable) {
+        file.close();
+        if (!m_pieceTable->load(m_filePath)) {
+            emit loadingError("File could not be opened.");
+            return;
+        }
+
+        setProgress(1, 1);
+        emit loadingFinished();
+        return;
+    }
+
+    // Prefer decoding straight from a memory mapping; fall back to the stream
+    // reader for files that cannot be mapped (pipes, some network shares).
+    if (m_fileSize > 0) {
+        uchar *data = file.map(0, m_fileSize);
+        if (data) {
+            loadMapped(reinterpret_cast<const char *>(data), m_fileSize);
+            file.unmap(data);
+            file.close();
+
+            setProgress(1, 1);
+            emit loadingFinished();
+            return;
+        }
+        qDebug() << "Mapping failed, falling back to streamed loading:" << file.errorString();
+    }
+
+    const qint64 chunkSize = 1024 * 1024;  // Progress is polled, so chunks only need to bound memory
     QTextStream in(&file);
     in.setEncoding(QStringConverter::Utf8); // FIXME: Load in QByteArray buffer too (for encodings)
 
     qint64 bytesRead = 0;
-    int lastReportedProgress = 0;
-    auto lastUpdateTime = std::chrono::steady_clock::now();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    qint64 characters = 0;
 
-    while (!in.atEnd()) {
+    while (!in.atEnd() && !m_cancelled.load(std::memory_order_relaxed)) {
         QString buffer = in.read(chunkSize);
         if (buffer.isEmpty()) break;
 
-        bytesRead += buffer.toUtf8().size();
+        // Never split a CRLF pair, as loadMapped: it would hash and display as two line breaks
+        if (buffer.endsWith(QLatin1Char('\r')) && !in.atEnd()) {
+            buffer += in.read(1);
+        }
+
+        bytesRead = file.pos();  // Device position; cheap, unlike QTextStream::pos()
+        characters += addPlainText(hash, buffer);
         emit contentLoaded(buffer);  // Emit content incrementally
+        setProgress(bytesRead, m_fileSize);
+    }
+
+    if (in.atEnd()) {
+        emit contentHashDetermined(m_filePath, hash.result(), characters);
+    }
+
+    setProgress(1, 1);  // Ensure progress reaches 100%
+    emit loadingFinished();
+    file.close();
+}
+
+void FileLoaderWorker::loadMapped(const char *data, qint64 size) {
+    const qint64 sliceSize = 4 * 1024 * 1024;  // Page aligned, large enough to keep signal traffic low
+    QStringDecoder decoder(QStringConverter::Utf8);  // Stateful: carries split multi-byte sequences over
 
-        // Calculate current progress percentage
-        int currentProgress = static_cast<int>((bytesRead * 100) / m_fileSize);
+    qint64 offset = 0;
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    qint64 characters = 0;
+    bool hasCarriageReturn = false;
+    const bool hasBom = size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0;
 
-        // Throttle updates: emit only if 100ms has passed since the last update
-        auto now = std::chrono::steady_clock::now();
-        if (currentProgress > lastReportedProgress &&
-            std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdateTime).count() > 100) {
+    while (offset < size && !m_cancelled.load(std::memory_order_relaxed)) {
+        qint64 length = qMin(sliceSize, size - offset);
+        hasCarriageReturn = hasCarriageReturn || std::memchr(data + offset, '\r', length);
+
+        // Never split a CRLF pair, the editor would turn it into two line breaks
+        if (offset + length < size && data[offset + length - 1] == '\r') {
+            ++length;
+        }
 
-            lastReportedProgress = currentProgress;
-            emit loadingProgress(currentProgress);  // Emit progress
+        QString chunk = decoder.decode(QByteArrayView(data + offset, length));
+        offset += length;
 
-            // Update last update time and process UI events
-            lastUpdateTime = now;
-            QCoreApplication::processEvents();
+        if (!chunk.isEmpty()) {
+            characters += addPlainText(hash, chunk);
+            emit contentLoaded(chunk);
         }
+
+        // Progress comes from the mapping offset, no need to re-encode anything
+        setProgress(offset, size);
     }
 
-    emit loadingProgress(100);  // Ensure progress reaches 100%
-    emit loadingFinished();
-    file.close();
+    if (decoder.hasError()) {
+        qDebug() << "File contains invalid UTF-8 sequences:" << m_filePath;
+    }
+
+    if (offset == size) {
+        emit contentHashDetermined(m_filePath, hash.result(), characters);
+    }
+
+    // QTextDocument::toPlainText() turns these into a space or '\n', changing byte offsets
+    const std::string_view text(data, size);
+    const bool hasConvertedCharacters = text.find("\xC2\xA0") != std::string_view::npos      // U+00A0
+                                        || text.find("\xE2\x80\xA8") != std::string_view::npos  // U+2028
+                                        || text.find("\xE2\x80\xA9") != std::string_view::npos; // U+2029
+
+    // Only then do the file's bytes equal the UTF-8 of the editor text, which lets
+    // later saves patch the file in place.
+    emit plainUtf8Determined(offset == size && !hasCarriageReturn && !hasBom && !hasConvertedCharacters && !decoder.hasError());
 }
 
 void FileLoaderWorker::saveFile(const QString &filePath, const QString &fileContent) {
     qDebug() << "Saving file to path: " << filePath;
-    QFile file(filePath);
 
+    // Written to a temporary file and renamed over the target on commit, so a failed
+    // save never leaves a truncated file behind.
+    QSaveFile file(filePath);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         qDebug() << "Failed to open file for writing: " << file.errorString();
         emit errorOccurred("Failed to open file for saving.");
         return;
     }
 
-    QTextStream out(&file);
-    out.setEncoding(QStringConverter::Utf8);  // Set encoding
-    qint64 totalBytes = fileContent.toUtf8().size();
-    qint64 bytesWritten = 0;
-    qint64 chunkSize = calculateChunkSize(totalBytes);  // Reuse the same chunk size logic
+    m_progress.store(0, std::memory_order_relaxed);
+    emit savingStarted();
+
+    // One encoding pass: each slice goes through the encoder straight into the file.
+    // The encoder is stateful, so a surrogate pair split between slices is kept intact.
+    const qsizetype sliceSize = 1024 * 1024;  // Characters per slice, bounds the encoded buffer
+    const qsizetype totalCharacters = fileContent.size();
+    QStringEncoder encoder(QStringConverter::Utf8);
+    bool ok = true;
+
+    for (qsizetype offset = 0; offset < totalCharacters && ok; offset += sliceSize) {
+        const QByteArray encoded = encoder.encode(QStringView(fileContent).mid(offset, sliceSize));
+        ok = file.write(encoded) == encoded.size();
+        setProgress(qMin(offset + sliceSize, totalCharacters), totalCharacters);
+    }
+
+    if (encoder.hasError()) {
+        qDebug() << "Unpaired surrogates were replaced while encoding:" << filePath;
+    }
+
+    if (ok && file.commit()) {
+        reportContentHash(filePath, fileContent);
+        emit savingFinished();
+        qDebug() << "File saved successfully to: " << filePath;
+    } else {
+        qDebug() << "Failed to write file: " << file.errorString();
+        file.cancelWriting();
+        emit errorOccurred("Failed to write to file.");
+    }
+}
 
-    while (bytesWritten < totalBytes) {
-        QString chunk = fileContent.mid(bytesWritten, chunkSize);  // Write in chunks
-        out << chunk;
-        out.flush();  // Ensure the data is written
+// Writes only what changed since the file was last loaded or saved. `firstChanged` and
+// `unchangedTail` bound the edited span in characters (possibly generously, format-only
+// changes widen it too); the file must still have `fileSize` bytes and be the plain
+// UTF-8 of the old text (no BOM, no CR). The span is narrowed against the bytes on
+// disk, then same-length edits are patched in place and a short remainder is rewritten
+// from the first difference. Anything else falls back to the atomic full save.
+void FileLoaderWorker::saveChanges(const QString &filePath, const QString &fileContent,
+                                   qsizetype firstChanged, qsizetype unchangedTail, qint64 fileSize) {
+    const QStringView text(fileContent);
+    const qsizetype changedEnd = text.size() - unchangedTail;
+    if (firstChanged < 0 || changedEnd < firstChanged) {
+        saveFile(filePath, fileContent);
+        return;
+    }
 
-        bytesWritten += chunk.toUtf8().size();  // Increment bytes written
+    const qint64 prefixBytes = utf8Length(text.first(firstChanged));
+    const QByteArray changed = text.sliced(firstChanged, changedEnd - firstChanged).toUtf8();
+    const qint64 tailBytes = utf8Length(text.last(unchangedTail));
+    const qint64 newSize = prefixBytes + changed.size() + tailBytes;
+    const qint64 oldChangedBytes = fileSize - prefixBytes - tailBytes;
 
-        // Emit saving progress
-        int progress = static_cast<int>((bytesWritten * 100) / totalBytes);
-        emit savingProgress(progress);
+    QFile file(filePath);
+    if (oldChangedBytes < 0 || !file.open(QIODevice::ReadWrite) || file.size() != fileSize) {
+        qDebug() << "File changed on disk or cannot be opened, saving in full:" << filePath;
+        file.close();
+        saveFile(filePath, fileContent);
+        return;
+    }
 
-        // Allow the UI to remain responsive
-        QCoreApplication::processEvents();
+    // Narrow the span to the bytes that really differ, reading the old ones in blocks
+    const qint64 blockSize = 1024 * 1024;
+    const qint64 common = qMin<qint64>(oldChangedBytes, changed.size());
+    qint64 same = 0;
+    while (same < common && file.seek(prefixBytes + same)) {
+        const QByteArray old = file.read(qMin(blockSize, common - same));
+        if (old.isEmpty()) break;
+        qint64 i = 0;
+        while (i < old.size() && old.at(i) == changed.at(same + i)) ++i;
+        same += i;
+        if (i < old.size()) break;
     }
 
-    // Finalize the save operation
-    if (out.status() == QTextStream::Ok) {
+    qint64 sameTail = 0;
+    if (oldChangedBytes == changed.size()) {
+        while (sameTail < common - same) {
+            const qint64 length = qMin(blockSize, common - same - sameTail);
+            if (!file.seek(prefixBytes + oldChangedBytes - sameTail - length)) break;
+            const QByteArray old = file.read(length);
+            if (old.size() != length) break;
+            qint64 i = 0;
+            while (i < length && old.at(length - 1 - i) == changed.at(changed.size() - 1 - sameTail - i)) ++i;
+            sameTail += i;
+            if (i < length) break;
+        }
+    }
+
+    const qint64 writeOffset = prefixBytes + same;
+    QByteArray bytes;
+    if (oldChangedBytes == changed.size()) {
+        bytes = changed.sliced(same, changed.size() - same - sameTail);  // Same length: patch the difference
+    } else if (newSize - writeOffset < newSize / 2) {
+        bytes = changed.sliced(same) + text.last(unchangedTail).toUtf8();  // Short remainder: rewrite it
+    } else {
         file.close();
+        saveFile(filePath, fileContent);
+        return;
+    }
+
+    m_progress.store(0, std::memory_order_relaxed);
+    emit savingStarted();
+
+    const bool ok = file.seek(writeOffset)
+                    && file.write(bytes) == bytes.size()
+                    && (newSize == fileSize || file.resize(newSize))
+                    && file.flush();
+    file.close();
+
+    if (ok) {
+        setProgress(1, 1);
+        reportContentHash(filePath, fileContent);
         emit savingFinished();
-        qDebug() << "File saved successfully to: " << filePath;
+        qDebug() << "Patched" << bytes.size() << "of" << newSize << "bytes in place:" << filePath;
+    } else {
+        qDebug() << "Failed to patch file: " << file.errorString();
+        emit errorOccurred("Failed to write to file.");
+    }
+}
+
+qsizetype FileLoaderWorker::addPlainText(QCryptographicHash &hash, QStringView text) {
+    auto addRaw = [&hash](QStringView raw) {
+        hash.addData(QByteArrayView(reinterpret_cast<const char *>(raw.utf16()), raw.size() * sizeof(char16_t)));
+    };
+
+    // Fast path: nothing the editor would convert
+    auto needsConversion = [](QChar ch) {
+        return ch == QLatin1Char('\r') || ch == QChar::Nbsp || ch == QChar::LineSeparator || ch == QChar::ParagraphSeparator;
+    };
+    if (std::none_of(text.begin(), text.end(), needsConversion)) {
+        addRaw(text);
+        return text.size();
+    }
+
+    QString plain;
+    plain.reserve(text.size());
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar ch = text.at(i);
+        if (ch == QLatin1Char('\r')) {
+            if (i + 1 < text.size() && text.at(i + 1) == QLatin1Char('\n')) ++i;
+            plain.append(QLatin1Char('\n'));
+        } else if (ch == QChar::LineSeparator || ch == QChar::ParagraphSeparator) {
+            plain.append(QLatin1Char('\n'));
+        } else if (ch == QChar::Nbsp) {
+            plain.append(QLatin1Char(' '));
+        } else {
+            plain.append(ch);
+        }
+    }
+    addRaw(plain);
+    return plain.size();
+}
+
+void FileLoaderWorker::reportContentHash(const QString &filePath, QStringView text) {
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    const qsizetype length = addPlainText(hash, text);
+    emit contentHashDetermined(filePath, hash.result(), length);
+}
+
+// Bytes needed to encode `text` as UTF-8, matching what QStringEncoder writes.
+qint64 FileLoaderWorker::utf8Length(QStringView text) {
+    qint64 length = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t unit = text.at(i).unicode();
+        if (unit < 0x80) {
+            length += 1;
+        } else if (unit < 0x800) {
+            length += 2;
+        } else if (QChar::isHighSurrogate(unit) && i + 1 < text.size() && QChar::isLowSurrogate(text.at(i + 1).unicode())) {
+            length += 4;
+            ++i;
+        } else {
+            length += 3;  // Includes unpaired surrogates, written as U+FFFD
+        }
+    }
+    return length;
+}
+
+void FileLoaderWorker::savePieceTable(const QString &filePath, std::shared_ptr<const PieceTable> pieceTable) {
+    if (!pieceTable) {
+        emit errorOccurred("No piece table to save.");
+        return;
+    }
+
+    qDebug() << "Saving piece table to path: " << filePath;
+
+    // QSaveFile writes to a temporary file and renames it on commit, so the
+    // original file stays intact (and mapped) until the new content is complete.
+    // Windows refuses that rename while the file is mapped; Document::startSave has the
+    // table let go of it first (PieceTable::detachFile).
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to open file for writing: " << file.errorString();
+        emit errorOccurred("Failed to open file for saving.");
+        return;
+    }
+
+    m_progress.store(0, std::memory_order_relaxed);
+    emit savingStarted();
+
+    const qint64 totalBytes = pieceTable->size();
+    qint64 bytesWritten = 0;
+    bool ok = true;
+
+    pieceTable->forEachSpan(0, totalBytes, [&](const char *data, qint64 length) {
+        ok = file.write(data, length) == length;
+        bytesWritten += length;
+        setProgress(bytesWritten, totalBytes);
+        return ok;
+    });
+
+    if (ok && file.commit()) {
+        emit savingFinished();
+        qDebug() << "Piece table saved successfully to: " << filePath;
     } else {
+        file.cancelWriting();
         emit errorOccurred("Failed to write to file.");
     }
 }
@@ -142,7 +430,7 @@ void FileLoaderWorker::loadFile(const QString &filePath) {
     QString bufferedContent;
     QTextStream in(&file);
 
-    while (!in.atEnd()) {
+    while (!in.atEnd() && !m_cancelled.load(std::memory_order_relaxed)) {
         QString buffer = in.read(chunkSize);  // Read the file chunk
         if (buffer.isEmpty()) {
             qDebug() << "Read an empty buffer. Stopping at bytesRead: " << bytesRead;
@@ -153,12 +441,7 @@ void FileLoaderWorker::loadFile(const QString &filePath) {
         qDebug() << "Read chunk of size: " << buffer.size() << " Total bytesRead: " << bytesRead;
 
         emit contentLoaded(buffer);
-        QCoreApplication::processEvents();
-
-        // Update progress bar
-        int progress = static_cast<int>((bytesRead * 100) / m_fileSize);
-        qDebug() << "Updated progress: " << progress << "%";
-        emit loadingProgress(progress);
+        setProgress(bytesRead, fileSize);
     }
 
     // Emit remaining content in buffer
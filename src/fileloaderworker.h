@@ -2,9 +2,13 @@
 
 #include <QObject>
 #include <QFile>
+#include <QCryptographicHash>
+#include <atomic>
+#include <memory>
 #include "document.h"
 
 class Document;
+class PieceTable;
 class MainWindow;
 
 class FileLoaderWorker : public QObject {
@@ -14,12 +18,24 @@ public:
     explicit FileLoaderWorker(const QString &filePath, Document *doc, QObject *parent = nullptr);
     ~FileLoaderWorker();
     void saveFile(const QString &filePath, const QString &fileContent);
+    void saveChanges(const QString &filePath, const QString &fileContent,
+                     qsizetype firstChanged, qsizetype unchangedTail, qint64 fileSize);
     void loadFile(const QString &filePath);
+    void savePieceTable(const QString &filePath, std::shared_ptr<const PieceTable> pieceTable);
+    void setPieceTable(PieceTable *pieceTable);
+
+    // Safe to call from any thread; the GUI polls progress() instead of receiving a
+    // signal per step, and cancel() makes a running load return early.
+    int progress() const;
+    void cancel();
+
+    // Feeds text to `hash` the way QTextDocument::toPlainText() would return it, so a
+    // hash taken while loading matches one taken from the editor later. Returns the
+    // number of characters hashed.
+    static qsizetype addPlainText(QCryptographicHash &hash, QStringView text);
 
 signals:
     void loadingStarted();
-    void loadingProgress(qint64 bytesRead);
-        void savingProgress(qint64 progress);
     void loadingFinished();
     void savingStarted();
     void savingFinished();
@@ -27,13 +43,23 @@ signals:
     void contentLoaded(const QString &chunk);
     void loadingError(const QString &errorMsg);
     void fileSizeDetermined(qint64 fileSize);
+    void plainUtf8Determined(bool plainUtf8);
+    void contentHashDetermined(const QString &filePath, const QByteArray &hash, qint64 length);
 
 public slots:
     void startLoading();
 
 private:
+    void loadMapped(const char *data, qint64 size);
+    void setProgress(qint64 done, qint64 total);
+    static qint64 utf8Length(QStringView text);
+    void reportContentHash(const QString &filePath, QStringView text);
+
     QFile m_file;
     QString m_filePath;
     Document *document;
+    PieceTable *m_pieceTable = nullptr;
     qint64 m_fileSize;
+    std::atomic<int> m_progress{0};
+    std::atomic<bool> m_cancelled{false};
 };
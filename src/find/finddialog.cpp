@@ -1,17 +1,20 @@
 #include <QVBoxLayout>
 #include <QMessageBox>
 #include <QSettings>
+#include <QToolTip>
 #include "finddialog.h"
 #include "ui_finddialog.h"
 #include "../find/find.h"
 #include "../helpers.h"
 #include "../settings.h"
+#include "../search/incrementalsearch.h"
 
 FindDialog::FindDialog(QWidget* parent)
     : QDialog(parent),
     ui(new Ui::FindDialog),
     m_searchOptions(new SearchOptions()),
-    m_find(nullptr)
+    m_find(nullptr),
+    m_incrementalSearch(new IncrementalSearch(this))
 {
 
     ui->setupUi(this);
@@ -153,6 +156,10 @@ void FindDialog::on_findNext_clicked()
     }
 
     saveKeyword(keyword);  // Save without modifying UI
+    if (m_searchOptions->allTabs) {
+        emit allTabsSearchRequested(*m_searchOptions);  // Results go to a panel, grouped by tab
+        return;
+    }
     m_find->setSearchOptions(*m_searchOptions);
     m_find->findNext();
 }
@@ -168,6 +175,10 @@ void FindDialog::on_findPrevious_clicked()
     }
 
     saveKeyword(keyword);  // Save without modifying UI
+    if (m_searchOptions->allTabs) {
+        emit allTabsSearchRequested(*m_searchOptions);  // Results go to a panel, grouped by tab
+        return;
+    }
     m_find->setSearchOptions(*m_searchOptions);
     m_find->findPrevious();
 }
@@ -183,6 +194,10 @@ void FindDialog::on_selectAll_clicked()
     }
 
     saveKeyword(keyword);  // Save without modifying UI
+    if (m_searchOptions->allTabs) {
+        emit allTabsSearchRequested(*m_searchOptions);  // Results go to a panel, grouped by tab
+        return;
+    }
     m_find->setSearchOptions(*m_searchOptions);
     m_find->selectAll();
 }
@@ -190,6 +205,14 @@ void FindDialog::on_selectAll_clicked()
 void FindDialog::on_comboBoxFind_currentTextChanged(const QString &arg1)
 {
     m_searchOptions->keyword = arg1;
+    if (!m_largeEditor) {
+        m_incrementalSearch->update(*m_searchOptions);  // Find as you type
+    } else if (!arg1.isEmpty()) {
+        // Large files search on demand; say so next to the box rather than in a dialog per keystroke
+        QToolTip::showText(ui->comboBoxFind->mapToGlobal(QPoint(0, ui->comboBoxFind->height())),
+                           tr("Find as you type is not supported for large files. Use Find Next."),
+                           ui->comboBoxFind);
+    }
 }
 
 void FindDialog::on_comboBoxFind_currentIndexChanged(int index)
@@ -218,6 +241,11 @@ void FindDialog::on_findSpecialCharachters_toggled(bool checked)
     if (checked) m_searchOptions->findMethod = FindMethod::SpecialCharacters;
 }
 
+void FindDialog::on_findKeywordList_toggled(bool checked)
+{
+    if (checked) m_searchOptions->findMethod = FindMethod::KeywordList;
+}
+
 void FindDialog::on_matchWholeWord_toggled(bool checked)
 {
     m_searchOptions->matchWholeWord = checked;
@@ -230,16 +258,24 @@ void FindDialog::on_matchCase_toggled(bool checked)
 
 void FindDialog::on_checkBoxAllTabs_toggled(bool checked)
 {
-    if (checked) Helpers::notImplemented(this);
     m_searchOptions->allTabs = checked;
 }
 
 void FindDialog::setEditor(CodeEditor* editor) {
     m_editor = editor;               // Store the editor
+    m_incrementalSearch->setEditor(editor);
     if (m_find) {                    // If m_find already exists, clean it up
         delete m_find;
     }
     m_find = new Find(editor);       // Initialize m_find with the editor
+    m_find->setLargeEditor(m_largeEditor);
+}
+
+void FindDialog::setLargeEditor(LargeFileEditor* largeEditor) {
+    m_largeEditor = largeEditor;     // Null unless the document is shown by LargeFileEditor
+    if (m_find) {
+        m_find->setLargeEditor(largeEditor);
+    }
 }
 
 void FindDialog::showDialog(QWidget *parent) {
@@ -6,6 +6,8 @@
 #include "../codeeditor.h"
 #include "../search/searchoptions.h"
 
+class IncrementalSearch;
+
 namespace Ui {
 class FindDialog;
 }
@@ -27,11 +29,13 @@ public:
     bool isMatchCaseChecked() const;
     bool isAllTabsChecked() const;
     void setEditor(CodeEditor* editor);
+    void setLargeEditor(LargeFileEditor* largeEditor);
     Find* getFind();
     SearchOptions* getSearchOptions();
 
 signals:
     void findRequested(const QString& findText, bool matchCase, bool matchWholeWord, FindMethod mode);
+    void allTabsSearchRequested(const SearchOptions& options);
 
 private slots:
 
@@ -61,12 +65,16 @@ private slots:
 
     void on_findSpecialCharachters_toggled(bool checked);
 
+    void on_findKeywordList_toggled(bool checked);
+
 private:
     Ui::FindDialog *ui;
     FindMethod selectedFindMethod() const;
     SearchOptions* m_searchOptions;
     Find* m_find;
     CodeEditor* m_editor = nullptr;
+    IncrementalSearch* m_incrementalSearch;
+    LargeFileEditor* m_largeEditor = nullptr;
     void populateComboBoxOnDropdown();
     void saveKeyword(const QString& keyword);
     bool eventFilter(QObject *watched, QEvent *event);
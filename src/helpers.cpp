@@ -12,6 +12,7 @@
 #include "document.h"
 #include "codeeditor.h"
 #include "search/searchoptions.h"
+#include "search/patterncache.h"
 
 bool Helpers::isUntitledDocument(const QString& title) {
     // Static QRegularExpression to avoid repeated creation
@@ -133,13 +134,7 @@ int Helpers::countKeywordsInLine(const QString& line, const SearchOptions& optio
         return 0;
     }
 
-    QString pattern = options.matchWholeWord
-                          ? QString("\\b%1\\b").arg(QRegularExpression::escape(keyword))
-                          : QRegularExpression::escape(keyword);
-
-    QRegularExpression regex(pattern, options.matchCase
-                                          ? QRegularExpression::NoPatternOption
-                                          : QRegularExpression::CaseInsensitiveOption);
+    const QRegularExpression regex = PatternCache::instance().pattern(options);
 
     int count = 0;
     QRegularExpressionMatchIterator it = regex.globalMatch(line);
@@ -158,15 +153,8 @@ QString Helpers::highlightKeywords(const QString& line, const SearchOptions& opt
         return line; // No keyword to highlight
     }
 
-    // Build the regex pattern
-    QString pattern = options.matchWholeWord
-                          ? QString("\\b%1\\b").arg(QRegularExpression::escape(keyword)) // Whole word matching
-                          : QRegularExpression::escape(keyword); // Partial match
-
-    // Configure case sensitivity
-    QRegularExpression regex(pattern, options.matchCase
-                                          ? QRegularExpression::NoPatternOption
-                                          : QRegularExpression::CaseInsensitiveOption);
+    // Same compiled pattern as the search that produced the line
+    const QRegularExpression regex = PatternCache::instance().pattern(options);
 
     // Process the line and replace matches with highlighted versions
     QString highlightedLine;
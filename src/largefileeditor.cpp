@@ -0,0 +1,739 @@
+#define FONT_NAME "VL Gothic"
+
+#include "largefileeditor.h"
+#include <QApplication>
+#include <QClipboard>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QDebug>
+#include <algorithm>
+#include "piecetable.h"
+#include "settings.h"
+
+namespace {
+
+// Lines beyond this many bytes are only shown up to the limit
+constexpr qint64 kMaxDisplayLineBytes = 1 << 20;
+
+// Lines decoded above and below the viewport so small scrolls do not touch the table
+constexpr int kOverscanLines = 32;
+
+int utf8SequenceLength(uchar lead) {
+    if (lead < 0x80) return 1;
+    if ((lead & 0xE0) == 0xC0) return 2;
+    if ((lead & 0xF0) == 0xE0) return 3;
+    if ((lead & 0xF8) == 0xF0) return 4;
+    return 1;
+}
+
+} // namespace
+
+LargeFileEditor::LargeFileEditor(QWidget *parent)
+    : QAbstractScrollArea(parent), m_lineNumberArea(new LargeFileLineNumberArea(this)) {
+
+    QPalette p = viewport()->palette();
+    p.setColor(QPalette::Base, Qt::white);
+    p.setColor(QPalette::Text, Qt::black);
+    viewport()->setPalette(p);
+    viewport()->setAutoFillBackground(true);
+    viewport()->setCursor(Qt::IBeamCursor);
+    setFocusPolicy(Qt::StrongFocus);
+
+    QFont font;
+    font.setFamily(FONT_NAME); // Macro defined at top of the file
+    font.setFixedPitch(true);
+    font.setPointSize(12);
+    setFont(font);
+
+    m_tabWidth = Settings::instance()->loadSetting("View", "TabWidth", "4").toInt();
+    m_showTabs = Settings::instance()->loadSetting("View", "ShowTabs", "false") == "true";
+    m_showSpaces = Settings::instance()->loadSetting("View", "ShowSpaces", "false") == "true";
+    m_showEOL = Settings::instance()->loadSetting("View", "ShowEOL", "false") == "true";
+    m_showAllCharacters = Settings::instance()->loadSetting("View", "ShowAllCharacters", "false") == "true";
+    m_showIndentGuide = Settings::instance()->loadSetting("View", "ShowIndentGuide", "false") == "true";
+
+    if (m_showAllCharacters) {
+        m_showTabs = true;
+        m_showSpaces = true;
+        m_showEOL = true;
+    }
+
+    updateLineNumberAreaWidth();
+}
+
+void LargeFileEditor::setPieceTable(PieceTable *pieceTable) {
+    m_pieceTable = pieceTable;
+    reload();
+}
+
+PieceTable* LargeFileEditor::pieceTable() const {
+    return m_pieceTable;
+}
+
+// Called once the table has been (re)loaded; resets the view to the top of the file.
+void LargeFileEditor::reload() {
+    m_cursorOffset = 0;
+    m_anchorOffset = 0;
+    m_searchMatches.clear();
+    invalidateCache();
+    updateLineNumberAreaWidth();
+    updateScrollBars();
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    viewport()->update();
+    m_lineNumberArea->update();
+}
+
+qint64 LargeFileEditor::lineCount() const {
+    return m_pieceTable ? m_pieceTable->lineCount() : 1;
+}
+
+qint64 LargeFileEditor::currentLine() const {
+    return m_pieceTable ? m_pieceTable->lineAt(m_cursorOffset) : 0;
+}
+
+qint64 LargeFileEditor::selectionStart() const {
+    return qMin(m_anchorOffset, m_cursorOffset);
+}
+
+qint64 LargeFileEditor::selectionEnd() const {
+    return qMax(m_anchorOffset, m_cursorOffset);
+}
+
+// Selects [anchor, cursor) and scrolls the cursor end into view, e.g. for search results
+void LargeFileEditor::setSelection(qint64 anchor, qint64 cursor) {
+    if (!m_pieceTable) return;
+
+    m_anchorOffset = qBound<qint64>(0, anchor, m_pieceTable->size());
+    moveCursor(cursor, true);
+}
+
+void LargeFileEditor::setSearchMatches(const QVector<QPair<qint64, qint64>> &matches) {
+    m_searchMatches = matches;
+    viewport()->update();
+}
+
+void LargeFileEditor::clearSearchMatches() {
+    if (m_searchMatches.isEmpty()) return;
+    m_searchMatches.clear();
+    viewport()->update();
+}
+
+void LargeFileEditor::gotoLine(qint64 lineNumber) {
+    if (!m_pieceTable || lineNumber < 1 || lineNumber > lineCount()) {
+        qWarning() << "Invalid Line Number: " << lineNumber << " .The specified line is out of range.";
+        return;
+    }
+
+    moveCursor(m_pieceTable->lineStart(lineNumber - 1), false);
+
+    // Center the target line like QPlainTextEdit::centerCursor does
+    verticalScrollBar()->setValue(static_cast<int>(qMax<qint64>(0, lineNumber - 1 - visibleLineCount() / 2)));
+    horizontalScrollBar()->setValue(0);
+}
+
+int LargeFileEditor::lineHeight() const {
+    return fontMetrics().height();
+}
+
+qint64 LargeFileEditor::firstVisibleLine() const {
+    return verticalScrollBar()->value();
+}
+
+int LargeFileEditor::visibleLineCount() const {
+    return qMax(1, viewport()->height() / lineHeight());
+}
+
+int LargeFileEditor::lineNumberAreaWidth() const {
+    int digits = 1;
+    qint64 max = qMax<qint64>(1, lineCount());
+    while (max >= 10) {
+        max /= 10;
+        ++digits;
+    }
+
+    return 5 + fontMetrics().horizontalAdvance(QLatin1Char('9')) * digits;
+}
+
+void LargeFileEditor::updateLineNumberAreaWidth() {
+    setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+    QRect cr = contentsRect();
+    m_lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+}
+
+void LargeFileEditor::updateScrollBars() {
+    const qint64 lines = lineCount();
+    const int pageLines = visibleLineCount();
+    verticalScrollBar()->setRange(0, static_cast<int>(qMin<qint64>(INT_MAX, qMax<qint64>(0, lines - pageLines))));
+    verticalScrollBar()->setPageStep(pageLines);
+    verticalScrollBar()->setSingleStep(1);
+
+    // Only the decoded lines are measured, so the range grows as wider lines scroll in
+    int widest = 0;
+    for (const CachedLine &line : std::as_const(m_cache)) {
+        widest = qMax(widest, line.positions.isEmpty() ? 0 : line.positions.last());
+    }
+    const int charWidth = fontMetrics().horizontalAdvance(QLatin1Char(' '));
+    horizontalScrollBar()->setRange(0, qMax(horizontalScrollBar()->maximum(), widest + charWidth * 2 - viewport()->width()));
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setSingleStep(charWidth);
+}
+
+void LargeFileEditor::invalidateCache() {
+    m_cache.clear();
+    m_cacheFirstLine = -1;
+}
+
+// Returns the decoded line, rebuilding the cached window around it when needed.
+// The reference is only valid until the next call.
+const LargeFileEditor::CachedLine &LargeFileEditor::cachedLine(qint64 lineNumber) {
+    static const CachedLine empty{QString(), QVector<int>{0}, QVector<int>{0}};
+    if (!m_pieceTable || lineNumber < 0 || lineNumber >= lineCount()) return empty;
+
+    if (m_cacheFirstLine < 0 || lineNumber < m_cacheFirstLine || lineNumber >= m_cacheFirstLine + m_cache.size()) {
+        qint64 first = firstVisibleLine() - kOverscanLines;
+        qint64 last = firstVisibleLine() + visibleLineCount() + kOverscanLines;
+        if (lineNumber < first || lineNumber >= last) {
+            // Lines away from the viewport (cursor moves) get a window of their own
+            first = lineNumber - kOverscanLines;
+            last = lineNumber + kOverscanLines;
+        }
+        first = qMax<qint64>(0, first);
+        last = qMin(lineCount(), last);
+
+        const QFontMetrics metrics(font());
+        const int tabStop = qMax(1, m_tabWidth) * metrics.horizontalAdvance(QLatin1Char(' '));
+
+        m_cache.clear();
+        m_cache.reserve(last - first);
+        m_cacheFirstLine = first;
+
+        for (qint64 n = first; n < last; ++n) {
+            const qint64 start = m_pieceTable->lineStart(n);
+            qint64 end = m_pieceTable->lineEnd(n);
+            QByteArray bytes = m_pieceTable->read(start, qMin(end - start, kMaxDisplayLineBytes));
+            if (bytes.endsWith('\r')) bytes.chop(1);
+
+            // Decode by hand so every UTF-16 unit keeps the byte offset it came from;
+            // malformed sequences become U+FFFD one byte at a time.
+            CachedLine line;
+            line.text.reserve(bytes.size());
+            line.byteOffsets.reserve(bytes.size() + 1);
+            const uchar *data = reinterpret_cast<const uchar *>(bytes.constData());
+            const int size = bytes.size();
+            for (int i = 0; i < size;) {
+                int length = utf8SequenceLength(data[i]);
+                char32_t codePoint = QChar::ReplacementCharacter;
+                if (length == 1) {
+                    if (data[i] < 0x80) codePoint = data[i];
+                } else if (i + length <= size) {
+                    codePoint = data[i] & (0xFF >> (length + 1));
+                    for (int k = 1; k < length; ++k) {
+                        if ((data[i + k] & 0xC0) != 0x80) {
+                            codePoint = QChar::ReplacementCharacter;
+                            length = 1;
+                            break;
+                        }
+                        codePoint = (codePoint << 6) | (data[i + k] & 0x3F);
+                    }
+                } else {
+                    length = 1;
+                }
+
+                if (QChar::requiresSurrogates(codePoint)) {
+                    line.text.append(QChar::highSurrogate(codePoint));
+                    line.text.append(QChar::lowSurrogate(codePoint));
+                    line.byteOffsets.append(i);
+                    line.byteOffsets.append(i);
+                } else {
+                    line.text.append(QChar(static_cast<char16_t>(codePoint)));
+                    line.byteOffsets.append(i);
+                }
+                i += length;
+            }
+            line.byteOffsets.append(size);
+
+            line.positions.reserve(line.text.size() + 1);
+            int x = 0;
+            line.positions.append(x);
+            for (int i = 0; i < line.text.size(); ++i) {
+                const QChar ch = line.text.at(i);
+                if (ch == QLatin1Char('\t')) {
+                    x = (x / tabStop + 1) * tabStop;
+                } else if (!ch.isLowSurrogate()) {
+                    x += ch.isHighSurrogate() && i + 1 < line.text.size()
+                             ? metrics.horizontalAdvance(line.text.mid(i, 2))
+                             : metrics.horizontalAdvance(ch);
+                }
+                line.positions.append(x);
+            }
+
+            m_cache.append(line);
+        }
+    }
+
+    return m_cache.at(lineNumber - m_cacheFirstLine);
+}
+
+int LargeFileEditor::xForIndex(const CachedLine &line, int index) const {
+    return line.positions.at(qBound(0, index, static_cast<int>(line.positions.size()) - 1));
+}
+
+int LargeFileEditor::indexForX(const CachedLine &line, int x) const {
+    // Nearest character boundary to x
+    auto it = std::lower_bound(line.positions.cbegin(), line.positions.cend(), x);
+    if (it == line.positions.cend()) return static_cast<int>(line.positions.size()) - 1;
+    int index = static_cast<int>(it - line.positions.cbegin());
+    if (index > 0 && x - line.positions.at(index - 1) < *it - x) --index;
+    return index;
+}
+
+qint64 LargeFileEditor::offsetForPoint(const QPoint &point) {
+    if (!m_pieceTable) return 0;
+    const qint64 lineNumber = qBound<qint64>(0, firstVisibleLine() + point.y() / lineHeight(), lineCount() - 1);
+    const CachedLine &line = cachedLine(lineNumber);
+    const int index = indexForX(line, point.x() + horizontalScrollBar()->value());
+    return m_pieceTable->lineStart(lineNumber) + line.byteOffsets.at(index);
+}
+
+void LargeFileEditor::paintEvent(QPaintEvent *event) {
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), viewport()->palette().base());
+    if (!m_pieceTable) return;
+
+    const QFontMetrics metrics(font());
+    const int height = lineHeight();
+    const int xOffset = -horizontalScrollBar()->value();
+    const int width = viewport()->width();
+    const qint64 first = firstVisibleLine();
+    const qint64 last = qMin(lineCount(), first + visibleLineCount() + 1);
+    const qint64 cursorLine = currentLine();
+    const qint64 selectionStart = qMin(m_cursorOffset, m_anchorOffset);
+    const qint64 selectionEnd = qMax(m_cursorOffset, m_anchorOffset);
+
+    for (qint64 n = first; n < last; ++n) {
+        const int top = static_cast<int>(n - first) * height;
+        if (top > event->rect().bottom()) break;
+        if (top + height < event->rect().top()) continue;
+
+        const CachedLine &line = cachedLine(n);
+        const qint64 lineStart = m_pieceTable->lineStart(n);
+
+        if (n == cursorLine) {
+            painter.fillRect(QRect(0, top, width, height), QColor(Qt::yellow).lighter(160));
+        }
+
+        const qint64 lineEnd = lineStart + line.byteOffsets.last();
+        auto indexOf = [&line, lineStart](qint64 offset) {
+            auto it = std::lower_bound(line.byteOffsets.cbegin(), line.byteOffsets.cend(), offset - lineStart);
+            return static_cast<int>(it - line.byteOffsets.cbegin());
+        };
+
+        // Search matches on this line; they never span a line break
+        auto match = std::lower_bound(m_searchMatches.cbegin(), m_searchMatches.cend(), lineStart,
+                                      [](const QPair<qint64, qint64> &range, qint64 offset) { return range.second <= offset; });
+        for (; match != m_searchMatches.cend() && match->first < lineEnd; ++match) {
+            const int left = xForIndex(line, indexOf(match->first));
+            const int right = xForIndex(line, indexOf(qMin(match->second, lineEnd)));
+            painter.fillRect(QRect(left + xOffset, top, right - left, height), QColor(Qt::yellow));
+        }
+
+        // Selection covers the part of this line between the two offsets
+        if (selectionStart != selectionEnd) {
+            if (selectionStart <= lineEnd && selectionEnd > lineStart) {
+                const int left = selectionStart <= lineStart ? 0 : xForIndex(line, indexOf(selectionStart));
+                const int right = selectionEnd > lineEnd ? xForIndex(line, line.text.size()) + metrics.horizontalAdvance(QLatin1Char(' '))
+                                                         : xForIndex(line, indexOf(selectionEnd));
+                painter.fillRect(QRect(left + xOffset, top, right - left, height), palette().highlight());
+            }
+        }
+
+        // Draw runs between tabs; runs fully outside the viewport are skipped
+        painter.setPen(Qt::black);
+        int runStart = 0;
+        for (int i = 0; i <= line.text.size(); ++i) {
+            if (i < line.text.size() && line.text.at(i) != QLatin1Char('\t')) continue;
+            const int left = line.positions.at(runStart) + xOffset;
+            const int right = line.positions.at(i) + xOffset;
+            if (i > runStart && right >= 0 && left <= width) {
+                painter.drawText(left, top + metrics.ascent(), line.text.mid(runStart, i - runStart));
+            }
+            runStart = i + 1;
+        }
+
+        painter.setPen(Qt::gray);
+
+        if (m_showIndentGuide) {
+            int indent = 0;
+            while (indent < line.text.size() && (line.text.at(indent) == QLatin1Char(' ') || line.text.at(indent) == QLatin1Char('\t'))) {
+                ++indent;
+            }
+            if (indent > 0) {
+                const int x = line.positions.at(indent) + xOffset;
+                painter.drawLine(QPoint(x, top), QPoint(x, top + height - 1));
+            }
+        }
+
+        if (m_showTabs || m_showSpaces) {
+            for (int i = 0; i < line.text.size(); ++i) {
+                const int x = line.positions.at(i) + xOffset;
+                if (x > width) break;
+                if (m_showTabs && line.text.at(i) == QLatin1Char('\t')) {
+                    painter.drawText(QPoint(x + metrics.ascent(), top + metrics.ascent()), "→");
+                } else if (m_showSpaces && line.text.at(i) == QLatin1Char(' ')) {
+                    painter.drawText(QPoint(x + metrics.horizontalAdvance(' ') / 4,
+                                            top + metrics.ascent() / 2 + metrics.height() / 3), ".");
+                }
+            }
+        }
+
+        if (m_showEOL && n + 1 < lineCount()) {
+            painter.drawText(QPoint(line.positions.last() + xOffset + metrics.horizontalAdvance(' '), top + metrics.ascent()), "↵");
+        }
+    }
+
+    // Text cursor
+    if (hasFocus() && cursorLine >= first && cursorLine < last) {
+        const CachedLine &line = cachedLine(cursorLine);
+        const qint64 column = m_cursorOffset - m_pieceTable->lineStart(cursorLine);
+        auto it = std::lower_bound(line.byteOffsets.cbegin(), line.byteOffsets.cend(), column);
+        const int x = xForIndex(line, static_cast<int>(it - line.byteOffsets.cbegin())) + xOffset;
+        const int top = static_cast<int>(cursorLine - first) * height;
+        painter.setPen(Qt::black);
+        painter.drawLine(x, top, x, top + height - 1);
+    }
+}
+
+void LargeFileEditor::lineNumberAreaPaintEvent(QPaintEvent *event) {
+    QPainter painter(m_lineNumberArea);
+    painter.fillRect(event->rect(), Qt::lightGray);
+    if (!m_pieceTable) return;
+
+    const int height = lineHeight();
+    const qint64 first = firstVisibleLine();
+    const qint64 last = qMin(lineCount(), first + visibleLineCount() + 1);
+    const qint64 currentLineNumber = currentLine();
+
+    for (qint64 n = first; n < last; ++n) {
+        const int top = static_cast<int>(n - first) * height;
+        if (top > event->rect().bottom()) break;
+        if (top + height < event->rect().top()) continue;
+
+        if (n == currentLineNumber) {
+            QFont boldFont = painter.font();
+            boldFont.setBold(true);
+            painter.setFont(boldFont);
+            painter.setPen(Qt::blue);
+        } else {
+            painter.setFont(QFont());
+            painter.setPen(Qt::black);
+        }
+
+        painter.drawText(-5, top, m_lineNumberArea->width(), height,
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(n + 1));
+
+        painter.setPen(n == currentLineNumber ? Qt::red : Qt::blue);
+        painter.drawLine(0, top + height, m_lineNumberArea->width(), top + height);
+    }
+}
+
+void LargeFileEditor::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateLineNumberAreaWidth();
+    updateScrollBars();
+}
+
+void LargeFileEditor::scrollContentsBy(int dx, int dy) {
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    updateScrollBars();
+    viewport()->update();
+    m_lineNumberArea->update();
+}
+
+void LargeFileEditor::ensureCursorVisible() {
+    if (!m_pieceTable) return;
+
+    const qint64 line = currentLine();
+    const qint64 first = firstVisibleLine();
+    const int pageLines = visibleLineCount();
+    if (line < first) {
+        verticalScrollBar()->setValue(static_cast<int>(line));
+    } else if (line >= first + pageLines) {
+        verticalScrollBar()->setValue(static_cast<int>(line - pageLines + 1));
+    }
+
+    const CachedLine &cached = cachedLine(line);
+    auto it = std::lower_bound(cached.byteOffsets.cbegin(), cached.byteOffsets.cend(),
+                               m_cursorOffset - m_pieceTable->lineStart(line));
+    const int x = xForIndex(cached, static_cast<int>(it - cached.byteOffsets.cbegin()));
+    const int margin = fontMetrics().horizontalAdvance(QLatin1Char(' ')) * 4;
+    if (x < horizontalScrollBar()->value()) {
+        horizontalScrollBar()->setValue(qMax(0, x - margin));
+    } else if (x > horizontalScrollBar()->value() + viewport()->width() - margin) {
+        horizontalScrollBar()->setMaximum(qMax(horizontalScrollBar()->maximum(), x + margin - viewport()->width()));
+        horizontalScrollBar()->setValue(x + margin - viewport()->width());
+    }
+}
+
+void LargeFileEditor::moveCursor(qint64 offset, bool keepAnchor) {
+    if (!m_pieceTable) return;
+
+    m_cursorOffset = qBound<qint64>(0, offset, m_pieceTable->size());
+    if (!keepAnchor) {
+        m_anchorOffset = m_cursorOffset;
+    }
+
+    ensureCursorVisible();
+    viewport()->update();
+    m_lineNumberArea->update();
+    emit cursorPositionChanged();
+}
+
+qint64 LargeFileEditor::previousCharacter(qint64 offset) const {
+    if (offset <= 0) return 0;
+
+    // Step back over UTF-8 continuation bytes, and over "\r\n" as a whole
+    const QByteArray before = m_pieceTable->read(qMax<qint64>(0, offset - 4), qMin<qint64>(4, offset));
+    int i = before.size() - 1;
+    if (before.at(i) == '\n' && i > 0 && before.at(i - 1) == '\r') return offset - 2;
+    while (i > 0 && (static_cast<uchar>(before.at(i)) & 0xC0) == 0x80) --i;
+    return offset - (before.size() - i);
+}
+
+qint64 LargeFileEditor::nextCharacter(qint64 offset) const {
+    const qint64 size = m_pieceTable->size();
+    if (offset >= size) return size;
+
+    const QByteArray after = m_pieceTable->read(offset, 2);
+    if (after.startsWith("\r\n")) return offset + 2;
+    return qMin(size, offset + utf8SequenceLength(static_cast<uchar>(after.at(0))));
+}
+
+qint64 LargeFileEditor::verticalMove(qint64 offset, qint64 lines) {
+    const qint64 line = m_pieceTable->lineAt(offset);
+    const qint64 target = qBound<qint64>(0, line + lines, lineCount() - 1);
+    if (target == line) {
+        return lines < 0 ? 0 : m_pieceTable->size();
+    }
+
+    const CachedLine &current = cachedLine(line);
+    auto it = std::lower_bound(current.byteOffsets.cbegin(), current.byteOffsets.cend(),
+                               offset - m_pieceTable->lineStart(line));
+    const int x = xForIndex(current, static_cast<int>(it - current.byteOffsets.cbegin()));
+
+    const CachedLine &next = cachedLine(target);
+    return m_pieceTable->lineStart(target) + next.byteOffsets.at(indexForX(next, x));
+}
+
+bool LargeFileEditor::hasSelection() const {
+    return m_cursorOffset != m_anchorOffset;
+}
+
+void LargeFileEditor::removeSelection() {
+    if (!hasSelection()) return;
+
+    const qint64 start = qMin(m_cursorOffset, m_anchorOffset);
+    m_pieceTable->remove(start, qAbs(m_cursorOffset - m_anchorOffset));
+    m_cursorOffset = m_anchorOffset = start;
+}
+
+void LargeFileEditor::insertText(const QString &text) {
+    if (!m_pieceTable || (text.isEmpty() && !hasSelection())) return;
+
+    removeSelection();
+    const QByteArray bytes = text.toUtf8();
+    m_pieceTable->insert(m_cursorOffset, bytes);
+    m_searchMatches.clear(); // Their offsets no longer apply
+
+    invalidateCache();
+    updateLineNumberAreaWidth();
+    updateScrollBars();
+    moveCursor(m_cursorOffset + bytes.size(), false);
+    emit textChanged();
+}
+
+void LargeFileEditor::copySelection() {
+    if (!hasSelection()) return;
+
+    const qint64 start = qMin(m_cursorOffset, m_anchorOffset);
+    QApplication::clipboard()->setText(QString::fromUtf8(m_pieceTable->read(start, qAbs(m_cursorOffset - m_anchorOffset))));
+}
+
+void LargeFileEditor::keyPressEvent(QKeyEvent *event) {
+    if (!m_pieceTable) {
+        QAbstractScrollArea::keyPressEvent(event);
+        return;
+    }
+
+    const bool shift = event->modifiers().testFlag(Qt::ShiftModifier);
+    const bool control = event->modifiers().testFlag(Qt::ControlModifier);
+
+    if (event == QKeySequence::SelectAll) {
+        m_anchorOffset = 0;
+        moveCursor(m_pieceTable->size(), true);
+        return;
+    }
+    if (event == QKeySequence::Copy) {
+        copySelection();
+        return;
+    }
+    if (event == QKeySequence::Cut) {
+        copySelection();
+        if (hasSelection()) insertText(QString());
+        return;
+    }
+    if (event == QKeySequence::Paste) {
+        insertText(QApplication::clipboard()->text());
+        return;
+    }
+
+    const qint64 line = currentLine();
+
+    switch (event->key()) {
+    case Qt::Key_Left:
+        moveCursor(!shift && hasSelection() ? qMin(m_cursorOffset, m_anchorOffset) : previousCharacter(m_cursorOffset), shift);
+        return;
+    case Qt::Key_Right:
+        moveCursor(!shift && hasSelection() ? qMax(m_cursorOffset, m_anchorOffset) : nextCharacter(m_cursorOffset), shift);
+        return;
+    case Qt::Key_Up:
+        moveCursor(verticalMove(m_cursorOffset, -1), shift);
+        return;
+    case Qt::Key_Down:
+        moveCursor(verticalMove(m_cursorOffset, 1), shift);
+        return;
+    case Qt::Key_PageUp:
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - visibleLineCount());
+        moveCursor(verticalMove(m_cursorOffset, -visibleLineCount()), shift);
+        return;
+    case Qt::Key_PageDown:
+        verticalScrollBar()->setValue(verticalScrollBar()->value() + visibleLineCount());
+        moveCursor(verticalMove(m_cursorOffset, visibleLineCount()), shift);
+        return;
+    case Qt::Key_Home:
+        moveCursor(control ? 0 : m_pieceTable->lineStart(line), shift);
+        return;
+    case Qt::Key_End:
+        moveCursor(control ? m_pieceTable->size()
+                           : m_pieceTable->lineStart(line) + cachedLine(line).byteOffsets.last(), shift);
+        return;
+    case Qt::Key_Backspace:
+        if (!hasSelection()) m_anchorOffset = previousCharacter(m_cursorOffset);
+        insertText(QString());
+        return;
+    case Qt::Key_Delete:
+        if (!hasSelection()) m_anchorOffset = nextCharacter(m_cursorOffset);
+        insertText(QString());
+        return;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        insertText(QStringLiteral("\n"));
+        return;
+    case Qt::Key_Tab: {
+        // Same indentation rules as CodeEditor
+        const bool useTabs = Settings::instance()->loadSetting("Indentation", "Option", "Tabs") == "Tabs";
+        const int indentationWidth = Settings::instance()->loadSetting("Indentation", "Size", "1").toInt();
+        insertText(useTabs ? QString(indentationWidth, '\t') : QString(indentationWidth, ' '));
+        return;
+    }
+    default:
+        break;
+    }
+
+    const QString text = event->text();
+    if (!text.isEmpty() && !control && text.at(0).isPrint()) {
+        insertText(text);
+        return;
+    }
+
+    QAbstractScrollArea::keyPressEvent(event);
+}
+
+void LargeFileEditor::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton) {
+        moveCursor(offsetForPoint(event->position().toPoint()), event->modifiers().testFlag(Qt::ShiftModifier));
+    }
+    QAbstractScrollArea::mousePressEvent(event);
+}
+
+void LargeFileEditor::mouseMoveEvent(QMouseEvent *event) {
+    if (event->buttons() & Qt::LeftButton) {
+        moveCursor(offsetForPoint(event->position().toPoint()), true);
+    }
+    QAbstractScrollArea::mouseMoveEvent(event);
+}
+
+void LargeFileEditor::setShowTabs(bool enabled) {
+    if (m_showTabs != enabled) {
+        m_showTabs = enabled;
+        viewport()->update();
+    }
+}
+
+void LargeFileEditor::setShowSpaces(bool enabled) {
+    if (m_showSpaces != enabled) {
+        m_showSpaces = enabled;
+        viewport()->update();
+    }
+}
+
+void LargeFileEditor::setShowEOL(bool enabled) {
+    if (m_showEOL != enabled) {
+        m_showEOL = enabled;
+        viewport()->update();
+    }
+}
+
+void LargeFileEditor::setShowAllCharacters(bool enabled) {
+    if (m_showAllCharacters != enabled) {
+        m_showAllCharacters = enabled;
+        m_showTabs = enabled;
+        m_showSpaces = enabled;
+        m_showEOL = enabled;
+        viewport()->update();
+    }
+}
+
+void LargeFileEditor::setShowIndentGuide(bool enabled) {
+    if (m_showIndentGuide != enabled) {
+        m_showIndentGuide = enabled;
+        viewport()->update();
+    }
+}
+
+void LargeFileEditor::setTabWidth(int width) {
+    m_tabWidth = width;
+    invalidateCache(); // Cached x positions depend on the tab width
+    viewport()->update();
+}
+
+void LargeFileEditor::setFontSize(int pointSize) {
+    QFont currentFont = font();
+    currentFont.setPointSize(pointSize);
+    setFont(currentFont);
+
+    invalidateCache();
+    updateLineNumberAreaWidth();
+    updateScrollBars();
+    viewport()->update();
+    m_lineNumberArea->update();
+}
+
+void LargeFileEditor::zoomIn() {
+    if (font().pointSize() < 72) {
+        setFontSize(font().pointSize() + 1);
+    }
+}
+
+void LargeFileEditor::zoomOut() {
+    if (font().pointSize() > 8) {
+        setFontSize(font().pointSize() - 1);
+    }
+}
+
+void LargeFileEditor::defaultZoom() {
+    setFontSize(12);
+}
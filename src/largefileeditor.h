@@ -0,0 +1,130 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <QPair>
+#include <QVector>
+
+class QPaintEvent;
+class QResizeEvent;
+class QKeyEvent;
+class QMouseEvent;
+class PieceTable;
+class LargeFileLineNumberArea;
+
+// Editor view for files too large for QPlainTextEdit. Text lives in a PieceTable and only
+// the lines inside the viewport (plus a small overscan) are decoded and laid out.
+// Positions are byte offsets into the UTF-8 text held by the table.
+class LargeFileEditor : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    explicit LargeFileEditor(QWidget *parent = nullptr);
+
+    void setPieceTable(PieceTable *pieceTable);
+    PieceTable* pieceTable() const;
+    void reload();
+
+    void gotoLine(qint64 lineNumber);
+    qint64 currentLine() const;
+    qint64 lineCount() const;
+
+    // Byte offsets into the piece table
+    qint64 selectionStart() const;
+    qint64 selectionEnd() const;
+    void setSelection(qint64 anchor, qint64 cursor);
+
+    // Sorted, non-overlapping byte ranges highlighted until the next edit (Select All)
+    void setSearchMatches(const QVector<QPair<qint64, qint64>> &matches);
+    void clearSearchMatches();
+
+    void lineNumberAreaPaintEvent(QPaintEvent *event);
+    int lineNumberAreaWidth() const;
+
+    void setShowTabs(bool enabled);
+    void setShowSpaces(bool enabled);
+    void setShowEOL(bool enabled);
+    void setShowAllCharacters(bool enabled);
+    void setShowIndentGuide(bool enabled);
+    void setTabWidth(int width);
+    void zoomIn();
+    void zoomOut();
+    void defaultZoom();
+
+signals:
+    void textChanged();
+    void cursorPositionChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    struct CachedLine {
+        QString text;
+        QVector<int> byteOffsets; // Byte offset within the line of each character, plus the end
+        QVector<int> positions;   // X position of each character, plus the end
+    };
+
+    const CachedLine &cachedLine(qint64 lineNumber);
+    void invalidateCache();
+    void updateScrollBars();
+    void updateLineNumberAreaWidth();
+    void ensureCursorVisible();
+    void setFontSize(int pointSize);
+
+    qint64 firstVisibleLine() const;
+    int visibleLineCount() const;
+    int lineHeight() const;
+    int xForIndex(const CachedLine &line, int index) const;
+    int indexForX(const CachedLine &line, int x) const;
+    qint64 offsetForPoint(const QPoint &point);
+
+    void moveCursor(qint64 offset, bool keepAnchor);
+    qint64 previousCharacter(qint64 offset) const;
+    qint64 nextCharacter(qint64 offset) const;
+    qint64 verticalMove(qint64 offset, qint64 lines);
+    bool hasSelection() const;
+    void removeSelection();
+    void insertText(const QString &text);
+    void copySelection();
+
+    PieceTable *m_pieceTable = nullptr;
+    LargeFileLineNumberArea *m_lineNumberArea;
+
+    qint64 m_cursorOffset = 0;
+    qint64 m_anchorOffset = 0;
+
+    QVector<QPair<qint64, qint64>> m_searchMatches;
+
+    // Decoded lines for the viewport and overscan, rebuilt on scroll and edits
+    QVector<CachedLine> m_cache;
+    qint64 m_cacheFirstLine = -1;
+
+    int m_tabWidth;
+    bool m_showTabs = false;
+    bool m_showSpaces = false;
+    bool m_showEOL = false;
+    bool m_showAllCharacters = false;
+    bool m_showIndentGuide = false;
+};
+
+class LargeFileLineNumberArea : public QWidget {
+public:
+    LargeFileLineNumberArea(LargeFileEditor *editor) : QWidget(editor), m_editor(editor) {}
+
+    QSize sizeHint() const override {
+        return QSize(m_editor->lineNumberAreaWidth(), 0);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override {
+        m_editor->lineNumberAreaPaintEvent(event);
+    }
+
+private:
+    LargeFileEditor *m_editor;
+};
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cstring>
+#include <QtAlgorithms>
+#include "lineindex.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define LINEINDEX_X86
+#endif
+
+#if defined(LINEINDEX_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LINEINDEX_AVX2_DISPATCH
+#endif
+
+namespace {
+
+// Feeds every set bit of `mask` to `emit` as an offset from `position`
+template <typename Emit>
+inline void emitMask(quint32 mask, qint64 position, Emit &emit) {
+    while (mask) {
+        emit(position + qCountTrailingZeroBits(mask));
+        mask &= mask - 1;
+    }
+}
+
+template <typename Emit>
+void scanScalar(const char *data, qint64 begin, qint64 size, Emit &emit) {
+    for (qint64 i = begin; i < size;) {
+        const void *lineFeed = std::memchr(data + i, '\n', size - i);
+        if (!lineFeed) break;
+        const qint64 position = static_cast<const char *>(lineFeed) - data;
+        emit(position);
+        i = position + 1;
+    }
+}
+
+#if defined(LINEINDEX_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LINEINDEX_SSE2
+template <typename Emit>
+qint64 scanSse2(const char *data, qint64 size, Emit &emit) {
+    const __m128i lineFeeds = _mm_set1_epi8('\n');
+    qint64 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        emitMask(static_cast<quint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, lineFeeds))), i, emit);
+    }
+    return i;
+}
+#endif
+
+#ifdef LINEINDEX_AVX2_DISPATCH
+template <typename Emit>
+__attribute__((target("avx2"))) qint64 scanAvx2(const char *data, qint64 size, Emit &emit) {
+    const __m256i lineFeeds = _mm256_set1_epi8('\n');
+    qint64 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        emitMask(static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, lineFeeds))), i, emit);
+    }
+    return i;
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+// Picks the widest scanner the CPU supports, then finishes the tail with memchr
+template <typename Emit>
+void scan(const char *data, qint64 size, Emit emit) {
+    qint64 done = 0;
+#ifdef LINEINDEX_AVX2_DISPATCH
+    if (hasAvx2()) {
+        done = scanAvx2(data, size, emit);
+    }
+#endif
+#ifdef LINEINDEX_SSE2
+    if (done == 0) {
+        done = scanSse2(data, size, emit);
+    }
+#endif
+    scanScalar(data, done, size, emit);
+}
+
+} // namespace
+
+void LineIndex::clear() {
+    m_checkpoints.clear();
+    m_lineFeeds = 0;
+    m_indexed = 0;
+}
+
+// Counted a block at a time, so a checkpoint lands on every block start
+void LineIndex::append(const char *data, qint64 size, qint64 base) {
+    qint64 done = 0;
+    while (done < size) {
+        const qint64 position = base + done;
+        if (position % kBlockSize == 0) {
+            m_checkpoints.append(m_lineFeeds);
+        }
+        const qint64 end = qMin(size, (position / kBlockSize + 1) * kBlockSize - base);
+        m_lineFeeds += count(data + done, end - done);
+        done = end;
+    }
+    m_indexed = base + size;
+}
+
+qint64 LineIndex::size() const {
+    return m_lineFeeds;
+}
+
+qint64 LineIndex::countInRange(const char *data, qint64 start, qint64 length) const {
+    if (start / kBlockSize == (start + length) / kBlockSize) {
+        return count(data + start, length);  // Within one block: the range is the shorter scan
+    }
+    return lineFeedsBefore(data, start + length) - lineFeedsBefore(data, start);
+}
+
+qint64 LineIndex::nthFrom(const char *data, qint64 start, qint64 n) const {
+    const qint64 target = lineFeedsBefore(data, start) + n;
+
+    // The last block that starts with at most `target` line feeds before it holds the one wanted
+    const auto block = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), target) - 1;
+    qint64 skip = target - *block;
+    qint64 position = (block - m_checkpoints.cbegin()) * kBlockSize;
+    for (;;) {
+        const char *lineFeed = static_cast<const char *>(std::memchr(data + position, '\n', m_indexed - position));
+        if (skip-- == 0) return lineFeed - data;
+        position = lineFeed - data + 1;
+    }
+}
+
+qint64 LineIndex::lineFeedsBefore(const char *data, qint64 position) const {
+    if (m_checkpoints.isEmpty()) return 0;
+
+    const qint64 block = qMin(position / kBlockSize, qint64(m_checkpoints.size()) - 1);
+    const qint64 from = block * kBlockSize;
+    return m_checkpoints.at(block) + count(data + from, position - from);
+}
+
+qint64 LineIndex::count(const char *data, qint64 size) {
+    qint64 total = 0;
+    scan(data, size, [&total](qint64) {
+        ++total;
+    });
+    return total;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QVector>
+
+// Line feed counts of a buffer, kept as one checkpoint per kBlockSize bytes: the number
+// of '\n' before the block. Lookups rescan at most one block with the vectorized scan
+// (AVX2 or SSE2 where available, memchr otherwise), so the index of a multi-gigabyte
+// file takes kilobytes rather than eight bytes per line.
+class LineIndex {
+public:
+    void clear();
+
+    // Scans `size` bytes and counts their line feeds; `base` is the offset of `data`
+    // within the indexed buffer. Calls must come in buffer order.
+    void append(const char *data, qint64 size, qint64 base);
+
+    qint64 size() const;
+
+    // Number of line feeds in [start, start + length) of the indexed buffer `data`
+    qint64 countInRange(const char *data, qint64 start, qint64 length) const;
+
+    // Offset of the n-th (0-based) line feed at or after `start`; it must exist
+    qint64 nthFrom(const char *data, qint64 start, qint64 n) const;
+
+    // Counts line feeds without recording them
+    static qint64 count(const char *data, qint64 size);
+
+private:
+    qint64 lineFeedsBefore(const char *data, qint64 position) const;
+
+    static constexpr qint64 kBlockSize = 16 * 1024;
+
+    QVector<qint64> m_checkpoints;  // Line feeds before each block
+    qint64 m_lineFeeds = 0;
+    qint64 m_indexed = 0;           // Bytes scanned so far
+};
@@ -8,6 +8,7 @@
 #include <QPlainTextEdit>
 #include "mainwindow.h"
 #include "codeeditor.h"
+#include "largefileeditor.h"
 #include "settings.h"
 #include "mainwindow/mainwindowconfigloader.h"
 #include "mainwindow/textoperations.h"
@@ -175,6 +176,20 @@ MainWindow::MainWindow(QWidget* parent)
     m_mainWindowConfigLoader = new MainWindowConfigLoader(this);
     m_mainWindowConfigLoader->loadMainWindowConfig();
 
+    m_matchCountLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(m_matchCountLabel);
+    m_lineCountLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(m_lineCountLabel);
+    updateLineCountLabel();
+
+    m_tabSearch = new TabSearch(this);
+    connect(findDialog, &FindDialog::allTabsSearchRequested, this, &MainWindow::searchAllTabs);
+    connect(m_tabSearch, &TabSearch::tabSearched, this, [this](const FileSearchResults& result) {
+        if (m_tabSearchResultDialog) {
+            m_tabSearchResultDialog->addSearchResult(result);
+        }
+    });
+
     connect(ui->documentsTab, &QTabWidget::currentChanged, this, &MainWindow::onTabChanged);
     if (ui->documentsTab->count() > 0) {
         m_currentTabIndex = ui->documentsTab->currentIndex();
@@ -480,6 +495,7 @@ void MainWindow::on_actionReplace_N_ext_triggered()
         qDebug() << "replaceDialog is null.";
         return;
     }
+    if (replaceDialog->rejectLargeFile()) return;
 
     replaceDialog->getReplace()->replaceNext();
 }
@@ -490,6 +506,7 @@ void MainWindow::on_actionReplace_P_revious_triggered()
         qDebug() << "findDialog is null.";
         return;
     }
+    if (replaceDialog->rejectLargeFile()) return;
 
     replaceDialog->getReplace()->replacePrevious();
 }
@@ -586,13 +603,65 @@ void MainWindow::setupSearchResultDialogConnectionsForReplace() {
     });
 }
 
+// Snapshots every tab and searches them concurrently; results stream into a fresh panel
+void MainWindow::searchAllTabs(const SearchOptions& options) {
+    QVector<TabSearch::Snapshot> snapshots;
+    m_tabSearchDocuments.clear();
+    int loading = 0;
+
+    for (int i = 0; i < ui->documentsTab->count(); ++i) {
+        Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
+        if (!doc) continue;
+        if (doc->isLoading()) {
+            ++loading;  // Its worker thread is still writing the text; reported in the title
+            continue;
+        }
+
+        QString name = doc->filePath().isEmpty() ? ui->documentsTab->tabText(i) : doc->filePath();
+        if (m_tabSearchDocuments.contains(name)) {
+            name = QString("%1 (%2)").arg(name).arg(i + 1); // Untitled tabs share a title
+        }
+        m_tabSearchDocuments.insert(name, doc);
+        snapshots.append(TabSearch::snapshot(doc, name));
+    }
+
+    delete m_tabSearchResultDialog;
+    m_tabSearchResultDialog = new SystemSearchResultDialog(this);
+    m_tabSearchResultDialog->setAttribute(Qt::WA_DeleteOnClose);
+    m_tabSearchResultDialog->setWindowModality(Qt::NonModal);
+    m_tabSearchResultDialog->setWindowTitle(loading == 0 ? tr("Find in All Tabs")
+                                                         : tr("Find in All Tabs (%1 still loading, not searched)").arg(loading));
+    m_tabSearchResultDialog->setSearchOptions(options);
+    m_tabSearchResultDialog->setLoadLinesFromFiles(false); // Tabs may differ from their files
+    connect(m_tabSearchResultDialog, &SystemSearchResultDialog::openFileAtMatch,
+            this, &MainWindow::openTabSearchResult);
+    m_tabSearchResultDialog->show();
+
+    m_tabSearch->start(snapshots, options);
+}
+
+void MainWindow::openTabSearchResult(const QString& name, int lineNumber) {
+    Document *doc = m_tabSearchDocuments.value(name);
+    if (!doc) {
+        qDebug() << "Tab of search result is closed:" << name;
+        return;
+    }
+    ui->documentsTab->setCurrentWidget(doc);
+    doc->goToLine(lineNumber);
+}
+
 void MainWindow::on_actionGo_to_Line_in_Text_triggered()
 {
     int lineNumber = QInputDialog::getInt(this, "Go to Line in Text", "Enter line number:");
     if (lineNumber < 1) {
         QMessageBox::warning(this, "Warning", "Enter a valid number.", QMessageBox::Ok);
     } else {
-        getCurrentDocument()->editor()->goToLineInText(lineNumber);
+        Document *doc = getCurrentDocument();
+        if (doc && doc->largeEditor()) {
+            doc->largeEditor()->gotoLine(lineNumber);
+        } else if (doc) {
+            doc->editor()->goToLineInText(lineNumber);
+        }
     }
 }
 
@@ -602,7 +671,12 @@ void MainWindow::on_actionGo_to_Line_in_Editor_triggered()
     if (lineNumber < 1) {
         QMessageBox::warning(this, "Warning", "Enter a valid number.", QMessageBox::Ok);
     } else {
-        getCurrentDocument()->editor()->gotoLineInEditor(lineNumber);
+        Document *doc = getCurrentDocument();
+        if (doc && doc->largeEditor()) {
+            doc->largeEditor()->gotoLine(lineNumber);
+        } else if (doc) {
+            doc->editor()->gotoLineInEditor(lineNumber);
+        }
     }
 }
 
@@ -629,6 +703,9 @@ void MainWindow::on_action_Show_Tabs_triggered(bool checked)
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->setShowTabs(checked);
+            if (doc->largeEditor()) {
+                doc->largeEditor()->setShowTabs(checked);
+            }
         }
     }
 }
@@ -641,6 +718,9 @@ void MainWindow::on_actionShow_Spaces_triggered(bool checked)
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->setShowSpaces(checked);
+            if (doc->largeEditor()) {
+                doc->largeEditor()->setShowSpaces(checked);
+            }
         }
     }
 }
@@ -653,6 +733,9 @@ void MainWindow::on_actionShow_End_of_Lines_triggered(bool checked)
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->setShowEOL(checked);
+            if (doc->largeEditor()) {
+                doc->largeEditor()->setShowEOL(checked);
+            }
         }
     }
 }
@@ -665,6 +748,9 @@ void MainWindow::on_actionShow_All_Characters_triggered(bool checked)
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->setShowAllCharacters(checked);
+            if (doc->largeEditor()) {
+                doc->largeEditor()->setShowAllCharacters(checked);
+            }
         }
     }
 }
@@ -677,6 +763,9 @@ void MainWindow::on_actionShow_Indent_Guide_triggered(bool checked)
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->setShowIndentGuide(checked);
+            if (doc->largeEditor()) {
+                doc->largeEditor()->setShowIndentGuide(checked);
+            }
         }
     }
 }
@@ -699,6 +788,9 @@ void MainWindow::on_actionZoom_In_triggered()
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->zoomIn();
+            if (doc->largeEditor()) {
+                doc->largeEditor()->zoomIn();
+            }
         }
     }
 }
@@ -709,6 +801,9 @@ void MainWindow::on_actionoom_Out_triggered()
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->zoomOut();
+            if (doc->largeEditor()) {
+                doc->largeEditor()->zoomOut();
+            }
         }
     }
 }
@@ -719,6 +814,9 @@ void MainWindow::on_action_Restore_Default_Zoom_triggered()
         Document *doc = qobject_cast<Document *>(ui->documentsTab->widget(i));
         if (doc) {
             doc->editor()->defaultZoom();
+            if (doc->largeEditor()) {
+                doc->largeEditor()->defaultZoom();
+            }
         }
     }
 }
@@ -808,6 +906,27 @@ void MainWindow::onTabChanged(int currentIndex)
     // Update former and current tab indices
     m_formerTabIndex = m_currentTabIndex;
     m_currentTabIndex = currentIndex;
+    updateLineCountLabel();
+    updateMatchCountLabel();
+}
+
+void MainWindow::updateLineCountLabel() {
+    if (!m_lineCountLabel) return;
+
+    Document *doc = getCurrentDocument();
+    if (!doc || doc->isLoading()) {
+        m_lineCountLabel->clear();  // Counted once loadingFinished arrives
+        return;
+    }
+    m_lineCountLabel->setText(QString("Lines: %L1").arg(doc->lineCount()));
+}
+
+void MainWindow::updateMatchCountLabel() {
+    if (!m_matchCountLabel) return;
+
+    Document *doc = getCurrentDocument();
+    const int count = doc ? doc->editor()->searchMatchCount() : 0;
+    m_matchCountLabel->setText(count > 0 ? QString("Matches: %L1").arg(count) : QString());
 }
 
 void MainWindow::on_actionMath_Rendering_triggered(bool checked)
@@ -1748,7 +1867,7 @@ void MainWindow::openSearchResult(const QString &filePath, int lineNumber) {
 
     QTimer::singleShot(200, this, [lineNumber, safeDoc]() {
         if (safeDoc && safeDoc->editor()) {
-            safeDoc->editor()->goToLineInText(lineNumber);
+            safeDoc->goToLine(lineNumber);
         } else {
             qWarning() << "Document or editor is no longer available.";
         }
@@ -1775,6 +1894,24 @@ void MainWindow::connectSignals(Document *doc)
         applyColorCoding(doc, changed);
     });
 
+    // Keep the status bar line count current; both counts come from indexes, not scans.
+    auto refreshLineCount = [this, doc]() {
+        if (doc == getCurrentDocument()) {
+            updateLineCountLabel();
+        }
+    };
+    connect(doc->editor(), &QPlainTextEdit::blockCountChanged, this, refreshLineCount);
+    connect(doc, &Document::loadingFinished, this, refreshLineCount);  // Emitted once the document is no longer loading
+    if (doc->largeEditor()) {
+        connect(doc->largeEditor(), &LargeFileEditor::textChanged, this, refreshLineCount);
+    }
+
+    connect(doc->editor(), &CodeEditor::searchMatchesChanged, this, [this, doc]() {
+        if (doc == getCurrentDocument()) {
+            updateMatchCountLabel();
+        }
+    });
+
     // Connect the worker’s save completion signal.
     connect(doc->worker(), &FileLoaderWorker::savingFinished, this, [this, doc]() {
         applyColorCoding(doc, false);
@@ -1833,6 +1970,7 @@ void MainWindow::setActiveDocumentEditorInFindDialog() {
         if (activeEditor) {
             // Set the active editor in the find dialog
             findDialog->setEditor(activeEditor);
+            findDialog->setLargeEditor(activeDocument->largeEditor());
         } else {
             qWarning() << "Warning: No active editor found in document.";
         }
@@ -1853,6 +1991,7 @@ void MainWindow::setActiveDocumentEditorInReplaceDialog() {
         if (activeEditor) {
             // Set the active editor in the find dialog
             replaceDialog->setEditor(activeEditor);
+            replaceDialog->setLargeEditor(activeDocument->largeEditor());
         } else {
             qWarning() << "Warning: No active editor found in document.";
         }
@@ -3,7 +3,9 @@
 #include <QActionGroup>
 #include <QRadioButton>
 #include <QGroupBox>
+#include <QHash>
 #include <QMainWindow>
+#include <QPointer>
 #include "document.h"
 #include "find/finddialog.h"
 #include "replace/replacedialog.h"
@@ -15,6 +17,7 @@
 #include "systemfind/systemfinddialog.h"
 #include "systemreplace/systemreplacedialog.h"
 #include "systemsearchresultdialog.h"
+#include "search/tabsearch.h"
 #include "view/movetootherview.h"
 #include "view/movetonewview.h"
 #include "view/openinnewwindow.h"
@@ -218,10 +221,14 @@ private:
     Formatting* formatting;
     RecentFiles* recentFiles;
     void applyColorCoding(Document* doc, bool isModified);
+    void updateLineCountLabel();
+    void updateMatchCountLabel();
     void setActiveDocumentEditorInFindDialog();
     void setActiveDocumentEditorInReplaceDialog();
     void setupSearchResultDialogConnectionsForFind();
     void setupSearchResultDialogConnectionsForReplace();
+    void searchAllTabs(const SearchOptions& options);
+    void openTabSearchResult(const QString& name, int lineNumber);
 
     void setupIndentationMenu();
     QAction* action_Custom;
@@ -244,4 +251,9 @@ private:
     WordWrap* m_wordWrap = nullptr;
     int m_currentTabIndex;
     int m_formerTabIndex;
+    QLabel* m_lineCountLabel = nullptr;
+    QLabel* m_matchCountLabel = nullptr;
+    TabSearch* m_tabSearch = nullptr;
+    QPointer<SystemSearchResultDialog> m_tabSearchResultDialog;
+    QHash<QString, QPointer<Document>> m_tabSearchDocuments;   // Result group name -> tab
 };
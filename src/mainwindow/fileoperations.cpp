@@ -3,7 +3,6 @@
 #include <QTabWidget>
 #include <QMessageBox>
 #include <QFileDialog>
-#include <QMimeDatabase>
 #include <QClipboard>
 #include <QDebug>
 #include "fileoperations.h"
@@ -12,6 +11,7 @@
 #include "../mainwindow.h"
 #include "../document.h"
 #include "../codeeditor.h"
+#include "../search/textclassifier.h"
 
 FileOperations::FileOperations(MainWindow* mainWindow, QObject* parent)
     : QObject(parent), m_mainWindow(mainWindow)
@@ -146,26 +146,23 @@ void FileOperations::openFolder(MainWindow* mainWindow) {
         return;
     }
 
-    QMimeDatabase mimeDatabase;
     bool textFilesFound = false;
 
     for (const QString& fileName : fileList) {
         QString filePath = directory.absoluteFilePath(fileName);
 
-        QMimeType mimeType = mimeDatabase.mimeTypeForFile(filePath);
-
-        if (mimeType.name().startsWith("text/")) {
-            qDebug() << "Opening file with MIME type:" << mimeType.name();
+        if (TextClassifier::instance().isText(filePath)) {
+            qDebug() << "Opening text file:" << filePath;
             m_mainWindow->getFileOperations()->openDocument(filePath);  // Open in a new tab
             textFilesFound = true;
         } else {
-            qDebug() << "Skipping file with MIME type:" << mimeType.name();
+            qDebug() << "Skipping binary file:" << filePath;
         }
     }
 
     if (!textFilesFound) {
         QMessageBox::information(mainWindow, QObject::tr("No Text Files Found"),
-                                 QObject::tr("No text files were found in the selected folder based on MIME types."));
+                                 QObject::tr("No text files were found in the selected folder."));
     }
 }
 
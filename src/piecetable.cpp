@@ -0,0 +1,322 @@
+#include <QDebug>
+#include "piecetable.h"
+
+PieceTable::PieceTable() {}
+
+bool PieceTable::load(const QString &filePath) {
+    clear();
+
+    auto original = std::make_shared<OriginalBuffer>();
+    original->file.setFileName(filePath);
+    if (!original->file.open(QIODevice::ReadOnly)) {
+        qDebug() << "PieceTable could not open file:" << filePath;
+        return false;
+    }
+
+    original->size = original->file.size();
+    if (original->size > 0) {
+        uchar *mapped = original->file.map(0, original->size);
+        if (mapped) {
+            original->data = reinterpret_cast<const char *>(mapped);
+        } else {
+            // Not mappable (pipe, special file system): keep a private copy instead
+            original->storage = original->file.readAll();
+            original->size = original->storage.size();
+            original->data = original->storage.constData();
+        }
+    }
+
+    // Count the line feeds once; lookups then rescan one index block at most
+    original->lineFeeds.append(original->data, original->size, 0);
+
+    m_original = original;
+    m_root = original->size > 0 ? createPiece(Source::Original, 0, original->size) : -1;
+    m_modified = false;
+    return true;
+}
+
+QString PieceTable::mappedFile() const {
+    return m_original && m_original->file.isOpen() ? m_original->file.fileName() : QString();
+}
+
+// Snapshots may be reading the current buffer on other threads, so it is replaced rather
+// than changed; the mapping goes once the last of them lets go of it
+void PieceTable::detachFile() {
+    if (mappedFile().isEmpty()) return;
+
+    auto copy = std::make_shared<OriginalBuffer>();
+    copy->storage = m_original->storage.isEmpty() ? QByteArray(m_original->data, m_original->size) : m_original->storage;
+    copy->data = copy->storage.constData();
+    copy->size = copy->storage.size();
+    copy->lineFeeds = m_original->lineFeeds;  // Same bytes, same line feeds
+    m_original = copy;
+}
+
+void PieceTable::clear() {
+    m_original.reset();
+    m_added.clear();
+    m_addedLineFeeds.clear();
+    m_pieces.clear();
+    m_freePieces.clear();
+    m_root = -1;
+    m_modified = false;
+}
+
+qint64 PieceTable::size() const {
+    return subtreeLength(m_root);
+}
+
+qint64 PieceTable::lineCount() const {
+    return subtreeLineFeeds(m_root) + 1;
+}
+
+bool PieceTable::isModified() const {
+    return m_modified;
+}
+
+void PieceTable::insert(qint64 offset, const QByteArray &text) {
+    if (text.isEmpty()) return;
+    offset = qBound<qint64>(0, offset, size());
+
+    const qint64 start = m_added.size();
+    m_added.append(text);
+    m_addedLineFeeds.append(text.constData(), text.size(), start);
+
+    int left = -1;
+    int right = -1;
+    split(m_root, offset, left, right);
+    m_root = merge(merge(left, createPiece(Source::Added, start, text.size())), right);
+    m_modified = true;
+}
+
+void PieceTable::remove(qint64 offset, qint64 length) {
+    offset = qBound<qint64>(0, offset, size());
+    length = qMin(length, size() - offset);
+    if (length <= 0) return;
+
+    int left = -1;
+    int middle = -1;
+    int right = -1;
+    split(m_root, offset, left, middle);
+    split(middle, length, middle, right);
+    releaseTree(middle);
+    m_root = merge(left, right);
+    m_modified = true;
+}
+
+QByteArray PieceTable::read(qint64 offset, qint64 length) const {
+    QByteArray result;
+    result.reserve(qMax<qint64>(0, qMin(length, size() - offset)));
+    forEachSpan(offset, length, [&result](const char *data, qint64 spanLength) {
+        result.append(data, spanLength);
+        return true;
+    });
+    return result;
+}
+
+QByteArray PieceTable::line(qint64 lineNumber) const {
+    const qint64 start = lineStart(lineNumber);
+    return read(start, lineEnd(lineNumber) - start);
+}
+
+// Offset of the first byte of a line (0-based), found by walking the line feed counts.
+qint64 PieceTable::lineStart(qint64 lineNumber) const {
+    if (lineNumber <= 0) return 0;
+    if (lineNumber >= lineCount()) return size();
+
+    qint64 remaining = lineNumber;
+    qint64 base = 0;
+    int node = m_root;
+
+    while (node >= 0) {
+        const Piece &piece = m_pieces[node];
+        const qint64 leftLineFeeds = subtreeLineFeeds(piece.left);
+
+        if (remaining <= leftLineFeeds) {
+            node = piece.left;
+        } else if (remaining <= leftLineFeeds + piece.lineFeeds) {
+            const qint64 lineFeed = bufferLineFeeds(piece.source).nthFrom(bufferData(piece.source), piece.start,
+                                                                          remaining - leftLineFeeds - 1);
+            return base + subtreeLength(piece.left) + (lineFeed - piece.start) + 1;
+        } else {
+            remaining -= leftLineFeeds + piece.lineFeeds;
+            base += subtreeLength(piece.left) + piece.length;
+            node = piece.right;
+        }
+    }
+
+    return size();
+}
+
+// Offset of the line feed terminating a line, or the end of the text for the last line.
+qint64 PieceTable::lineEnd(qint64 lineNumber) const {
+    if (lineNumber + 1 >= lineCount()) return size();
+    return lineStart(lineNumber + 1) - 1;
+}
+
+// 0-based line containing the given offset.
+qint64 PieceTable::lineAt(qint64 offset) const {
+    qint64 lineFeeds = 0;
+    int node = m_root;
+
+    while (node >= 0) {
+        const Piece &piece = m_pieces[node];
+        const qint64 leftLength = subtreeLength(piece.left);
+
+        if (offset < leftLength) {
+            node = piece.left;
+        } else if (offset < leftLength + piece.length) {
+            return lineFeeds + subtreeLineFeeds(piece.left)
+                   + countLineFeeds(piece.source, piece.start, offset - leftLength);
+        } else {
+            lineFeeds += subtreeLineFeeds(piece.left) + piece.lineFeeds;
+            offset -= leftLength + piece.length;
+            node = piece.right;
+        }
+    }
+
+    return lineFeeds;
+}
+
+void PieceTable::forEachSpan(qint64 offset, qint64 length, const SpanVisitor &visitor) const {
+    if (length <= 0 || m_root < 0) return;
+    bool running = true;
+    visit(m_root, 0, offset, offset + length, visitor, running);
+}
+
+int PieceTable::createPiece(Source source, qint64 start, qint64 length) {
+    // xorshift keeps the treap balanced without pulling in <random>
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+
+    Piece piece{source, start, length, countLineFeeds(source, start, length), m_seed};
+
+    int node;
+    if (!m_freePieces.empty()) {
+        node = m_freePieces.back();
+        m_freePieces.pop_back();
+        m_pieces[node] = piece;
+    } else {
+        node = static_cast<int>(m_pieces.size());
+        m_pieces.push_back(piece);
+    }
+
+    update(node);
+    return node;
+}
+
+void PieceTable::releaseTree(int node) {
+    if (node < 0) return;
+    releaseTree(m_pieces[node].left);
+    releaseTree(m_pieces[node].right);
+    m_freePieces.push_back(node);
+}
+
+void PieceTable::update(int node) {
+    Piece &piece = m_pieces[node];
+    piece.subtreeLength = piece.length + subtreeLength(piece.left) + subtreeLength(piece.right);
+    piece.subtreeLineFeeds = piece.lineFeeds + subtreeLineFeeds(piece.left) + subtreeLineFeeds(piece.right);
+}
+
+// Splits the tree so that `left` holds the first `offset` bytes, cutting a piece in two if needed.
+void PieceTable::split(int node, qint64 offset, int &left, int &right) {
+    if (node < 0) {
+        left = right = -1;
+        return;
+    }
+
+    const qint64 leftLength = subtreeLength(m_pieces[node].left);
+    const qint64 pieceLength = m_pieces[node].length;
+
+    if (offset <= leftLength) {
+        int subtree = -1;
+        split(m_pieces[node].left, offset, left, subtree);
+        m_pieces[node].left = subtree;
+        update(node);
+        right = node;
+    } else if (offset >= leftLength + pieceLength) {
+        int subtree = -1;
+        split(m_pieces[node].right, offset - leftLength - pieceLength, subtree, right);
+        m_pieces[node].right = subtree;
+        update(node);
+        left = node;
+    } else {
+        const qint64 head = offset - leftLength;
+        const int tail = createPiece(m_pieces[node].source, m_pieces[node].start + head, pieceLength - head);
+
+        Piece &piece = m_pieces[node];
+        const int rightSubtree = piece.right;
+        piece.length = head;
+        piece.lineFeeds = countLineFeeds(piece.source, piece.start, head);
+        piece.right = -1;
+        update(node);
+
+        left = node;
+        right = merge(tail, rightSubtree);
+    }
+}
+
+int PieceTable::merge(int left, int right) {
+    if (left < 0) return right;
+    if (right < 0) return left;
+
+    if (m_pieces[left].priority > m_pieces[right].priority) {
+        m_pieces[left].right = merge(m_pieces[left].right, right);
+        update(left);
+        return left;
+    }
+
+    m_pieces[right].left = merge(left, m_pieces[right].left);
+    update(right);
+    return right;
+}
+
+void PieceTable::visit(int node, qint64 base, qint64 from, qint64 to, const SpanVisitor &visitor, bool &running) const {
+    if (node < 0 || !running) return;
+
+    const Piece &piece = m_pieces[node];
+    const qint64 pieceBegin = base + subtreeLength(piece.left);
+    const qint64 pieceEnd = pieceBegin + piece.length;
+
+    if (from < pieceBegin) {
+        visit(piece.left, base, from, to, visitor, running);
+    }
+
+    const qint64 begin = qMax(from, pieceBegin);
+    const qint64 end = qMin(to, pieceEnd);
+    if (running && begin < end) {
+        running = visitor(bufferData(piece.source) + piece.start + (begin - pieceBegin), end - begin);
+    }
+
+    if (to > pieceEnd) {
+        visit(piece.right, pieceEnd, from, to, visitor, running);
+    }
+}
+
+const char *PieceTable::bufferData(Source source) const {
+    if (source == Source::Original) {
+        return m_original ? m_original->data : nullptr;
+    }
+    return m_added.constData();
+}
+
+const LineIndex &PieceTable::bufferLineFeeds(Source source) const {
+    static const LineIndex empty;
+    if (source == Source::Original) {
+        return m_original ? m_original->lineFeeds : empty;
+    }
+    return m_addedLineFeeds;
+}
+
+qint64 PieceTable::countLineFeeds(Source source, qint64 start, qint64 length) const {
+    return bufferLineFeeds(source).countInRange(bufferData(source), start, length);
+}
+
+qint64 PieceTable::subtreeLength(int node) const {
+    return node < 0 ? 0 : m_pieces[node].subtreeLength;
+}
+
+qint64 PieceTable::subtreeLineFeeds(int node) const {
+    return node < 0 ? 0 : m_pieces[node].subtreeLineFeeds;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "lineindex.h"
+
+// Text storage made of pieces that point either into the original file (memory mapped,
+// never modified) or into an append-only buffer holding everything typed since.
+// Offsets are byte offsets into the UTF-8 text. Pieces live in an implicit treap ordered
+// by document position, so edits and offset/line lookups are O(log n) in the piece count.
+class PieceTable {
+public:
+    // Called with consecutive spans of the text; return false to stop early.
+    using SpanVisitor = std::function<bool(const char *data, qint64 length)>;
+
+    PieceTable();
+
+    bool load(const QString &filePath);
+    void clear();
+
+    // The file the original text is read from, while it is still open (mapped or not)
+    QString mappedFile() const;
+    // Copies the original text into memory and lets go of the file, so it can be replaced;
+    // Windows refuses to rename over a mapped file. Costs the file's size in memory.
+    void detachFile();
+
+    qint64 size() const;
+    qint64 lineCount() const;
+    bool isModified() const;
+
+    void insert(qint64 offset, const QByteArray &text);
+    void remove(qint64 offset, qint64 length);
+
+    QByteArray read(qint64 offset, qint64 length) const;
+    QByteArray line(qint64 lineNumber) const;
+    qint64 lineStart(qint64 lineNumber) const;
+    qint64 lineEnd(qint64 lineNumber) const;
+    qint64 lineAt(qint64 offset) const;
+
+    void forEachSpan(qint64 offset, qint64 length, const SpanVisitor &visit) const;
+
+private:
+    enum class Source : quint8 { Original, Added };
+
+    struct Piece {
+        Source source;
+        qint64 start;
+        qint64 length;
+        qint64 lineFeeds;
+        quint32 priority;
+        int left = -1;
+        int right = -1;
+        qint64 subtreeLength = 0;
+        qint64 subtreeLineFeeds = 0;
+    };
+
+    struct OriginalBuffer {
+        QFile file;
+        const char *data = nullptr;
+        qint64 size = 0;
+        QByteArray storage;          // Used when the file cannot be mapped
+        LineIndex lineFeeds;
+    };
+
+    int createPiece(Source source, qint64 start, qint64 length);
+    void releaseTree(int node);
+    void update(int node);
+    void split(int node, qint64 offset, int &left, int &right);
+    int merge(int left, int right);
+    void visit(int node, qint64 base, qint64 from, qint64 to, const SpanVisitor &visitor, bool &running) const;
+
+    const char *bufferData(Source source) const;
+    const LineIndex &bufferLineFeeds(Source source) const;
+    qint64 countLineFeeds(Source source, qint64 start, qint64 length) const;
+    qint64 subtreeLength(int node) const;
+    qint64 subtreeLineFeeds(int node) const;
+
+    std::shared_ptr<OriginalBuffer> m_original;
+    QByteArray m_added;
+    LineIndex m_addedLineFeeds;
+    std::vector<Piece> m_pieces;
+    std::vector<int> m_freePieces;
+    int m_root = -1;
+    quint32 m_seed = 0x9e3779b9u;
+    bool m_modified = false;
+};
@@ -1,4 +1,3 @@
-#include <QCoreApplication>
 #include "replace.h"
 
 bool Replace::replaceNext() {
@@ -14,8 +13,5 @@ bool Replace::replacePrevious() {
 }
 
 void Replace::replaceAll() {
-    m_searchOptions->role = Role::ReplaceNext; // Using ReplaceNext to replace all until fixing replaceAll().
-    setSearchOptions(*m_searchOptions);
-    // replaceAll(); // FIXME: replaceAll causes segmentation fault.
-    while(search()) QCoreApplication::processEvents();
+    Search::replaceAll();
 }
@@ -2,16 +2,19 @@
 #include <QMessageBox>
 #include <QSettings>
 #include <QStringList>
+#include <QToolTip>
 #include "replacedialog.h"
 #include "ui_replacedialog.h"
 #include "../helpers.h"
 #include "../settings.h"
+#include "../search/incrementalsearch.h"
 
 ReplaceDialog::ReplaceDialog(QWidget* parent)
     : QDialog(parent),
     ui(new Ui::ReplaceDialog),
     m_searchOptions(new SearchOptions()),
-    m_replace(nullptr)
+    m_replace(nullptr),
+    m_incrementalSearch(new IncrementalSearch(this))
 {
 
     ui->setupUi(this);
@@ -219,6 +222,7 @@ void ReplaceDialog::on_replaceNext_clicked()
     }
 
     saveReplaceWith(replaceWith);  // Save without modifying UI
+    if (rejectLargeFile()) return;
     m_replace->setSearchOptions(*m_searchOptions);
     m_replace->replaceNext();
 }
@@ -257,6 +261,7 @@ void ReplaceDialog::on_replacePrevious_clicked()
     }
 
     saveReplaceWith(replaceWith);  // Save without modifying UI
+    if (rejectLargeFile()) return;
     m_replace->setSearchOptions(*m_searchOptions);
     m_replace->replacePrevious();
 }
@@ -295,6 +300,7 @@ void ReplaceDialog::on_replaceAll_clicked()
     }
 
     saveReplaceWith(replaceWith);  // Save without modifying UI
+    if (rejectLargeFile()) return;
     m_replace->setSearchOptions(*m_searchOptions);
     m_replace->replaceAll();
 }
@@ -302,6 +308,14 @@ void ReplaceDialog::on_replaceAll_clicked()
 void ReplaceDialog::on_comboBoxFind_currentTextChanged(const QString &arg1)
 {
     m_searchOptions->keyword = arg1;
+    if (!m_largeEditor) {
+        m_incrementalSearch->update(*m_searchOptions);  // Find as you type
+    } else if (!arg1.isEmpty()) {
+        // Large files search on demand; say so next to the box rather than in a dialog per keystroke
+        QToolTip::showText(ui->comboBoxFind->mapToGlobal(QPoint(0, ui->comboBoxFind->height())),
+                           tr("Find as you type is not supported for large files. Use Find Next."),
+                           ui->comboBoxFind);
+    }
 }
 
 void ReplaceDialog::on_comboBoxFind_currentIndexChanged(int index)
@@ -358,10 +372,27 @@ void ReplaceDialog::on_checkBoxAllTabs_toggled(bool checked)
 
 void ReplaceDialog::setEditor(CodeEditor* editor) {
     m_editor = editor;               // Store the editor
+    m_incrementalSearch->setEditor(editor);
     if (m_replace) {                    // If m_replace already exists, clean it up
         delete m_replace;
     }
     m_replace = new Replace(editor);       // Initialize m_replace with the editor
+    m_replace->setLargeEditor(m_largeEditor);
+}
+
+void ReplaceDialog::setLargeEditor(LargeFileEditor* largeEditor) {
+    m_largeEditor = largeEditor;     // Null unless the document is shown by LargeFileEditor
+    if (m_replace) {
+        m_replace->setLargeEditor(largeEditor);
+    }
+}
+
+// Large files are searched in the piece table, which Replace does not edit
+bool ReplaceDialog::rejectLargeFile() {
+    if (!m_largeEditor) return false;
+
+    QMessageBox::information(this, "Information", "Replace is not supported for large files.");
+    return true;
 }
 
 void ReplaceDialog::showDialog(QWidget *parent) {
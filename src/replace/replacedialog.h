@@ -6,6 +6,8 @@
 #include "../codeeditor.h"
 #include "../search/searchoptions.h"
 
+class IncrementalSearch;
+
 namespace Ui {
 class ReplaceDialog;
 }
@@ -28,7 +30,11 @@ public:
     bool isMatchCaseChecked() const;
     bool isAllTabsChecked() const;
     void setEditor(CodeEditor* editor);
+    void setLargeEditor(LargeFileEditor* largeEditor);
     Replace* getReplace();
+
+    // Tells the user Replace is unavailable and returns true when a large file is shown
+    bool rejectLargeFile();
     SearchOptions* getSearchOptions();
 
 signals:
@@ -77,6 +83,8 @@ private:
     SearchOptions* m_searchOptions;
     Replace* m_replace;
     CodeEditor* m_editor = nullptr;
+    IncrementalSearch* m_incrementalSearch;
+    LargeFileEditor* m_largeEditor = nullptr;
     void saveKeyword(const QString& keyword);
     void saveReplaceWith(const QString& replaceWith);
     bool eventFilter(QObject *watched, QEvent *event);
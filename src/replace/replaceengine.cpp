@@ -0,0 +1,128 @@
+#include <QRegularExpression>
+#include "replaceengine.h"
+#include "../search/literalsearch.h"
+#include "../search/patterncache.h"
+#include "../search/search.h"
+
+namespace {
+
+constexpr int kProgressStep = 1024 * 1024; // Characters between progress updates
+
+}
+
+void ReplaceEngine::run(QPromise<Result>& promise, const QString& text, const SearchOptions& options) {
+    promise.setProgressRange(0, int(text.size()));
+
+    Result result;
+    QString& output = result.text;
+    output.reserve(text.size());
+    qsizetype copied = 0;       // Source position up to which output is complete
+    qsizetype lastProgress = 0;
+
+    // Appends the source between the previous match and `start`, then the replacement
+    auto beginMatch = [&](qsizetype start) {
+        if (result.first < 0) {
+            result.first = int(start);
+        } else {
+            output.append(QStringView(text).mid(copied, start - copied));
+        }
+        ++result.count;
+    };
+    auto endMatch = [&](qsizetype end) {
+        copied = end;
+        result.last = int(end);
+        if (end - lastProgress >= kProgressStep) {
+            promise.setProgressValue(int(end));
+            lastProgress = end;
+        }
+    };
+
+    const QString literal = Search::literalKeyword(options);
+    if (!literal.isEmpty()) {
+        const QString replacement = options.findMethod == FindMethod::SpecialCharacters
+                                        ? PatternCache::expandSpecialCharacters(options.replaceText)
+                                        : options.replaceText;
+        const LiteralSearch literalSearch(literal, options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive);
+
+        qsizetype index = literalSearch.indexIn(text);
+        while (index >= 0 && !promise.isCanceled()) {
+            if (options.matchWholeWord && !LiteralSearch::isWholeWord(text, index, literalSearch.size())) {
+                index = literalSearch.indexIn(text, index + 1);
+                continue;
+            }
+            beginMatch(index);
+            output.append(replacement);
+            endMatch(index + literalSearch.size());
+            index = literalSearch.indexIn(text, index + literalSearch.size());
+        }
+    } else {
+        const QRegularExpression regex = PatternCache::instance().pattern(options);
+        if (!regex.isValid()) {
+            return;
+        }
+        const QVector<Part> parts = parseTemplate(options.replaceText);
+
+        // Line by line, like find, so ^ and $ keep their per-line meaning
+        qsizetype lineStart = 0;
+        while (lineStart <= text.size() && !promise.isCanceled()) {
+            qsizetype lineEnd = text.indexOf(QLatin1Char('\n'), lineStart);
+            if (lineEnd < 0) lineEnd = text.size();
+
+            QRegularExpressionMatchIterator it = regex.globalMatch(text.mid(lineStart, lineEnd - lineStart));
+            while (it.hasNext()) {
+                const QRegularExpressionMatch match = it.next();
+                if (match.capturedLength() == 0) continue;
+
+                beginMatch(lineStart + match.capturedStart());
+                for (const Part& part : parts) {
+                    if (part.group < 0) {
+                        output.append(part.text);
+                    } else {
+                        output.append(match.capturedView(part.group));
+                    }
+                }
+                endMatch(lineStart + match.capturedEnd());
+            }
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    if (promise.isCanceled()) {
+        return;
+    }
+
+    promise.setProgressValue(int(text.size()));
+    promise.addResult(result);
+}
+
+QVector<ReplaceEngine::Part> ReplaceEngine::parseTemplate(const QString& replacement) {
+    QVector<Part> parts;
+    QString literal;
+
+    for (qsizetype i = 0; i < replacement.size(); ++i) {
+        const QChar ch = replacement.at(i);
+        if (ch == QLatin1Char('\\') && i + 1 < replacement.size()) {
+            const QChar next = replacement.at(i + 1);
+            if (next.isDigit()) {
+                if (!literal.isEmpty()) {
+                    parts.append({literal, -1});
+                    literal.clear();
+                }
+                parts.append({QString(), next.digitValue()});
+                ++i;
+                continue;
+            }
+            if (next == QLatin1Char('\\')) {
+                literal.append(next); // "\\" is a literal backslash
+                ++i;
+                continue;
+            }
+        }
+        literal.append(ch);
+    }
+
+    if (!literal.isEmpty()) {
+        parts.append({literal, -1});
+    }
+    return parts;
+}
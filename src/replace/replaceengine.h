@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QPromise>
+#include <QString>
+#include <QVector>
+#include "../search/searchoptions.h"
+
+// Replace All in a single pass: matches are streamed into one pre-reserved output
+// string, so the cost is linear in the text and offsets never go stale. Meant to run
+// on a worker thread over a snapshot of the document.
+class ReplaceEngine {
+public:
+    struct Result {
+        int first = -1;     // Source range [first, last) that `text` replaces
+        int last = -1;
+        QString text;
+        int count = 0;      // Number of replacements
+    };
+
+    // Reports progress in characters of `text` and stops early when canceled
+    static void run(QPromise<Result>& promise, const QString& text, const SearchOptions& options);
+
+private:
+    // Piece of a replacement template: literal text, or a capture group for \0 - \9
+    struct Part {
+        QString text;
+        int group = -1;
+    };
+
+    static QVector<Part> parseTemplate(const QString& replacement);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+
+// Blocking FIFO of limited size between producer and consumer threads. A full queue
+// holds producers back, so a fast producer cannot buffer an unbounded backlog.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(qsizetype capacity)
+        : m_capacity(capacity) {
+    }
+
+    // Waits while the queue is full; false once it is closed
+    bool push(T value) {
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && qsizetype(m_items.size()) >= m_capacity) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_closed) return false;
+
+        m_items.push_back(std::move(value));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // Waits while the queue is empty; false once it is closed and drained
+    bool pop(T& value) {
+        QMutexLocker locker(&m_mutex);
+        while (m_items.empty() && !m_closed) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_items.empty()) return false;
+
+        value = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // No more pushes; consumers still receive what is queued
+    void close() {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    // Closes and drops what is queued, so consumers stop at once
+    void cancel() {
+        QMutexLocker locker(&m_mutex);
+        m_items.clear();
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    std::deque<T> m_items;
+    qsizetype m_capacity;
+    bool m_closed = false;
+};
@@ -0,0 +1,176 @@
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QThread>
+#include "directorywalker.h"
+
+namespace {
+
+constexpr int kProgressStep = 1024;  // Files found between progress signals
+
+}
+
+DirectoryWalker::DirectoryWalker(QObject* parent)
+    : QObject(parent) {
+    // Listing is mostly waiting on the file system, a few threads keep it busy
+    m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+}
+
+DirectoryWalker::~DirectoryWalker() {
+    cancel();
+}
+
+void DirectoryWalker::start(const QString& root, bool recursive, const QRegularExpression& fileNamePattern,
+                            const std::shared_ptr<PathQueue>& output) {
+    cancel();
+
+    m_output = output;
+    m_fileNamePattern = fileNamePattern;
+    m_recursive = recursive;
+    m_canceled = false;
+    m_filesFound = 0;
+    m_bytesFound = 0;
+
+    const int walkers = m_pool.maxThreadCount();
+    m_workers.clear();
+    for (int i = 0; i < walkers; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+
+    m_pendingDirectories = 1;
+    m_workers.front()->directories.push_back(root);
+
+    m_activeWalkers = walkers;
+    for (int i = 0; i < walkers; ++i) {
+        m_pool.start([this, i]() { walk(i); });
+    }
+}
+
+void DirectoryWalker::cancel() {
+    m_canceled = true;
+    wakeAll();
+    if (m_output) {
+        m_output->cancel();  // Unblocks a walker waiting on a full queue
+    }
+    m_pool.waitForDone();
+    m_output.reset();
+}
+
+int DirectoryWalker::filesFound() const {
+    return m_filesFound;
+}
+
+qint64 DirectoryWalker::bytesFound() const {
+    return m_bytesFound;
+}
+
+void DirectoryWalker::walk(int index) {
+    while (!m_canceled) {
+        QString directory;
+        if (takeDirectory(index, directory)) {
+            listDirectory(index, directory);
+            finishDirectory();
+            continue;
+        }
+
+        // Others are listing and may queue more; sleep until they do or the walk ends. The
+        // checks repeat under the mutex, so a wake-up between them and the wait is not lost.
+        QMutexLocker locker(&m_idleMutex);
+        if (m_pendingDirectories == 0) {
+            break;  // Nothing queued anywhere and nothing being listed
+        }
+        if (!m_canceled && !hasQueuedDirectory()) {
+            m_work.wait(&m_idleMutex);
+        }
+    }
+
+    // The last walker out ends the stream
+    if (--m_activeWalkers == 0 && !m_canceled) {
+        m_output->close();
+        emit finished(m_filesFound);
+    }
+}
+
+// Newest directory of our own first (depth first keeps deques short), else the oldest of
+// another walker's, which tends to be the root of a large unexplored subtree
+bool DirectoryWalker::takeDirectory(int index, QString& directory) {
+    {
+        Worker& own = *m_workers[index];
+        QMutexLocker locker(&own.mutex);
+        if (!own.directories.empty()) {
+            directory = std::move(own.directories.back());
+            own.directories.pop_back();
+            return true;
+        }
+    }
+
+    const int count = int(m_workers.size());
+    for (int offset = 1; offset < count; ++offset) {
+        Worker& victim = *m_workers[(index + offset) % count];
+        QMutexLocker locker(&victim.mutex);
+        if (!victim.directories.empty()) {
+            directory = std::move(victim.directories.front());
+            victim.directories.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirectoryWalker::pushDirectory(int index, const QString& directory) {
+    ++m_pendingDirectories;
+    {
+        Worker& own = *m_workers[index];
+        QMutexLocker locker(&own.mutex);
+        own.directories.push_back(directory);
+    }
+    QMutexLocker locker(&m_idleMutex);
+    m_work.wakeOne();
+}
+
+// The last directory out ends the walk, and every idle walker has to see that
+void DirectoryWalker::finishDirectory() {
+    if (--m_pendingDirectories == 0) {
+        wakeAll();
+    }
+}
+
+void DirectoryWalker::wakeAll() {
+    QMutexLocker locker(&m_idleMutex);
+    m_work.wakeAll();
+}
+
+bool DirectoryWalker::hasQueuedDirectory() const {
+    for (const std::unique_ptr<Worker>& worker : m_workers) {
+        QMutexLocker locker(&worker->mutex);
+        if (!worker->directories.empty()) return true;
+    }
+    return false;
+}
+
+void DirectoryWalker::listDirectory(int index, const QString& directory) {
+    const bool filterNames = !m_fileNamePattern.pattern().isEmpty();
+    QDirIterator it(directory, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+
+    while (it.hasNext() && !m_canceled) {
+        const QString path = it.next();
+        const QFileInfo info = it.fileInfo();
+
+        if (info.isDir()) {
+            if (m_recursive && !info.isSymLink()) {  // Links could lead back up the tree
+                pushDirectory(index, path);
+            }
+        } else if (info.isFile()) {
+            if (filterNames && !m_fileNamePattern.match(info.fileName()).hasMatch()) {
+                continue;
+            }
+            if (!m_output->push(path)) {
+                return;  // Canceled
+            }
+            m_bytesFound += info.size();
+            const int found = ++m_filesFound;
+            if (found % kProgressStep == 0) {
+                emit progress(found);
+            }
+        }
+    }
+}
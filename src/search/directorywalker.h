@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "boundedqueue.h"
+
+// Lists a directory tree on several threads and streams the paths of matching files
+// into a BoundedQueue, closing it when the walk is done. Each thread keeps its own deque
+// of directories still to list: it takes the newest one from its own deque and, when
+// that is empty, steals the oldest one from another thread. No single thread has to
+// walk a deep subtree alone, and consumers can start searching right away.
+class DirectoryWalker : public QObject {
+    Q_OBJECT
+
+public:
+    using PathQueue = BoundedQueue<QString>;
+
+    explicit DirectoryWalker(QObject* parent = nullptr);
+    ~DirectoryWalker();
+
+    // `fileNamePattern` filters file names; an empty pattern accepts every file
+    void start(const QString& root, bool recursive, const QRegularExpression& fileNamePattern,
+               const std::shared_ptr<PathQueue>& output);
+    void cancel();   // Stops the walk and waits for its threads
+
+    int filesFound() const;
+    qint64 bytesFound() const;  // Total size of the files found, final once finished()
+
+signals:
+    void progress(int filesFound);
+    void finished(int filesFound);
+
+private:
+    struct Worker {
+        QMutex mutex;
+        std::deque<QString> directories;
+    };
+
+    void walk(int index);
+    bool takeDirectory(int index, QString& directory);
+    void finishDirectory();
+    bool hasQueuedDirectory() const;
+    void wakeAll();
+    void pushDirectory(int index, const QString& directory);
+    void listDirectory(int index, const QString& directory);
+
+    QThreadPool m_pool;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::shared_ptr<PathQueue> m_output;
+    QRegularExpression m_fileNamePattern;
+    bool m_recursive = true;
+
+    QMutex m_idleMutex;                          // Idle walkers sleep on m_work
+    QWaitCondition m_work;                       // A directory was queued, or the walk ended
+    std::atomic<int> m_pendingDirectories{0};   // Queued or being listed
+    std::atomic<int> m_activeWalkers{0};
+    std::atomic<int> m_filesFound{0};
+    std::atomic<qint64> m_bytesFound{0};
+    std::atomic<bool> m_canceled{false};
+};
@@ -1,19 +1,99 @@
 #include <QFile>
+#include <QFileInfo>
 #include <QTextStream>
-#include <QMimeDatabase>
+#include <algorithm>
+#include <cstring>
 #include "filesearchworker.h"
+#include "patterncache.h"
+#include "keywordlist.h"
+#include "literalsearch.h"
+#include "search.h"
+#include "textclassifier.h"
+#include "trigramindex.h"
+
+namespace {
+
+constexpr int kProgressStep = 64;  // Files searched between progress signals in queue mode
+
+// UTF-16 length of UTF-8 `bytes` as QString::fromUtf8 decodes them; ASCII needs no decoding
+qsizetype utf16Length(const char* bytes, qint64 size) {
+    for (qint64 i = 0; i < size; ++i) {
+        if (static_cast<uchar>(bytes[i]) >= 0x80) {
+            return QString::fromUtf8(bytes, size).size();
+        }
+    }
+    return size;
+}
+
+}
 
 FileSearchWorker::FileSearchWorker(const QString& filePath, const SearchOptions& options)
     : m_filePath(filePath), m_options(options) {
     setAutoDelete(true);
 }
 
+FileSearchWorker::FileSearchWorker(const std::shared_ptr<BoundedQueue<QString>>& paths, const SearchOptions& options)
+    : m_options(options), m_paths(paths) {
+    setAutoDelete(true);
+}
+
 void FileSearchWorker::run() {
-    QMimeDatabase mimeDb;
-    QMimeType mimeType = mimeDb.mimeTypeForFile(m_filePath);
-    if (mimeType.name().startsWith("text/")) {
-        FileSearchResults result = searchInFile();
-        if (result.matchCount > 0) {
+    if (!m_paths) {
+        if (!isCanceled()) {  // Queued before the search was stopped
+            searchFile();
+        }
+        return;
+    }
+
+    int searched = 0;
+    while (!isCanceled() && m_paths->pop(m_filePath)) {
+        searchFile();
+        if (++searched == kProgressStep) {
+            emit filesSearched(searched);
+            searched = 0;
+        }
+    }
+    if (searched > 0) {
+        emit filesSearched(searched);
+    }
+}
+
+void FileSearchWorker::setResultQueue(const std::shared_ptr<ResultQueue>& results) {
+    m_results = results;
+}
+
+void FileSearchWorker::setControl(const std::shared_ptr<SearchControl>& control) {
+    m_control = control;
+}
+
+void FileSearchWorker::setKeywordList(const QSharedPointer<const KeywordList>& keywordList) {
+    m_keywordList = keywordList;
+}
+
+bool FileSearchWorker::isCanceled() const {
+    return m_control && m_control->isCanceled();
+}
+
+// The only text check of a directory search; the walker does not repeat it
+void FileSearchWorker::searchFile() {
+    if (!TextClassifier::instance().isText(m_filePath)) {
+        if (m_control) {
+            ++m_control->filesSearched;
+            m_control->bytesSearched += QFileInfo(m_filePath).size();
+        }
+        return;
+    }
+
+    FileSearchResults result = searchInFile();
+    if (m_control) {
+        ++m_control->filesSearched;
+        m_control->matches += result.matchCount;
+        if (m_control->isCanceled()) return;  // Possibly cut short; not worth showing
+    }
+    if (result.matchCount > 0) {
+        if (m_results) {
+            m_results->push(std::move(result));  // Waits while the GUI catches up
+        } else {
             emit fileProcessed(result);
         }
     }
@@ -25,70 +105,209 @@ FileSearchResults FileSearchWorker::searchInFile() {
     result.matchCount = 0;
 
     QFile file(m_filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return result;
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) return result;
 
-    QTextStream in(&file);
-    QRegularExpression pattern(m_options.keyword,
-                               m_options.matchCase ? QRegularExpression::NoPatternOption
-                                                   : QRegularExpression::CaseInsensitiveOption);
+    // Mapped rather than read; only the lines that hold a match are ever decoded
+    const qint64 size = file.size();
+    if (m_control) {
+        m_control->bytesSearched += size;
+    }
+    const uchar* mapped = file.map(0, size);
+    QByteArray buffer;
+    if (!mapped) {
+        buffer = file.readAll();
+    }
+    const char* data = mapped ? reinterpret_cast<const char*>(mapped) : buffer.constData();
+    const QByteArrayView bytes(data, mapped ? size : buffer.size());
 
-    int lineNumber = 0;
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QRegularExpressionMatchIterator it = pattern.globalMatch(line);
-        bool hasMatch = false;
+    // QTextStream picks UTF-16 and UTF-32 up from their BOM; keyword lists match decoded text
+    const bool wideText = bytes.startsWith("\xFF\xFE") || bytes.startsWith("\xFE\xFF")
+                          || bytes.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4));
+    if (wideText || m_options.findMethod == FindMethod::KeywordList) {
+        file.seek(0);
+        QTextStream in(&file);
+        if (m_options.findMethod == FindMethod::KeywordList) {
+            searchKeywordList(in, result);
+        } else {
+            searchStream(in, result);
+        }
+        return result;
+    }
 
-        QString highlightedLine = line; // For highlighting
-        qInfo() << "Highlight line from threadpool worker: " << highlightedLine;
+    const qint64 start = bytes.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+    const Qt::CaseSensitivity caseSensitivity = m_options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
 
-        while (it.hasNext()) {
-            QRegularExpressionMatch match = it.next();
+    // Needles with a line break go to the line path, where they never match, as before; so do
+    // the ones supportsUtf8() turns down, which the regex path folds in full Unicode
+    const QString keyword = Search::literalKeyword(m_options);
+    if (!keyword.isEmpty()) {
+        const LiteralSearch literal(keyword, caseSensitivity);
+        if (literal.supportsUtf8()) {
+            searchLiteral(bytes.sliced(start), literal, result);
+            return result;
+        }
+    }
 
-            // Highlight the keywords in the line
-            highlightedLine = highlightMatches(line, pattern);
+    // Every worker of a directory search gets the same pattern, compiled once
+    const QRegularExpression pattern = PatternCache::instance().pattern(m_options);
+    if (!pattern.isValid()) return result;
 
-            // Add the line number and the full line to `matches`
-            result.matches.append(qMakePair(lineNumber, highlightedLine));
+    // The longest literal run a regex match must contain finds the candidate lines. Only
+    // runs the byte search folds exactly qualify; "Straße" could reject lines the regex,
+    // folding full Unicode, would match.
+    std::unique_ptr<LiteralSearch> prefilter;
+    QStringList literals;
+    if (m_options.findMethod == FindMethod::RegularExpression && TrigramIndex::regexLiterals(m_options.keyword, literals)) {
+        for (const QString& candidate : std::as_const(literals)) {
+            if (candidate.size() < 2 || (prefilter && candidate.size() <= prefilter->size())) continue;
+            auto literal = std::make_unique<LiteralSearch>(candidate, caseSensitivity);
+            if (literal->supportsUtf8()) prefilter = std::move(literal);
+        }
+    }
+    searchLines(bytes.sliced(start), pattern, prefilter.get(), result);
+    return result;
+}
 
-            result.matchCount++;
-            hasMatch = true;
+// Literal matches straight in the UTF-8 bytes. Line numbers come from counting the
+// newlines between matches; the bytes before a match are decoded only when not ASCII, to
+// report its position in the decoded line.
+void FileSearchWorker::searchLiteral(QByteArrayView bytes, const LiteralSearch& literal, FileSearchResults& result) {
+    const char* data = bytes.data();
+    const qint64 size = bytes.size();
+    const qint64 needleSize = literal.utf8Size();
+
+    int lineNumber = 0;
+    qint64 counted = 0;     // Newlines before this offset are in lineNumber
+    QVector<QPair<qint64, qint64>> spans;
+
+    qint64 position = literal.indexIn(data, size, 0);
+    while (position >= 0 && !isCanceled()) {
+        lineNumber += int(std::count(data + counted, data + position, '\n'));
+        qint64 lineStart = position;
+        while (lineStart > counted && data[lineStart - 1] != '\n') --lineStart;
+        const char* newline = static_cast<const char*>(memchr(data + position, '\n', size_t(size - position)));
+        const qint64 lineEnd = newline ? newline - data : size;
+        const qint64 textEnd = lineEnd > lineStart && data[lineEnd - 1] == '\r' ? lineEnd - 1 : lineEnd;
+        if (position >= lineEnd) {  // A match on the line break itself; never part of a line
+            position = literal.indexIn(data, size, lineEnd + 1);
+            continue;
         }
 
-        if (hasMatch) {
-            // Append to `matchingLines` only if a match exists
-            result.matchingLines.append(highlightedLine);
+        spans.clear();
+        while (position >= 0 && position < lineEnd) {
+            if (position + needleSize <= textEnd
+                && (!m_options.matchWholeWord || LiteralSearch::isWholeWord(data, lineStart, textEnd, position, needleSize))) {
+                spans.append(qMakePair(position, position + needleSize));
+                position = literal.indexIn(data, size, position + needleSize);
+            } else {
+                position = literal.indexIn(data, size, position + 1);
+            }
         }
 
-        lineNumber++;
+        if (!spans.isEmpty()) {
+            const int firstRange = int(result.ranges.size());
+            qint64 lastIndex = lineStart;
+            qsizetype column = 0;   // UTF-16 offset of lastIndex in the line
+            for (const QPair<qint64, qint64>& span : std::as_const(spans)) {
+                column += utf16Length(data + lastIndex, span.first - lastIndex);
+                const qsizetype length = utf16Length(data + span.first, span.second - span.first);
+                result.ranges.append(qMakePair(int(column), int(length)));
+                column += length;
+                lastIndex = span.second;
+            }
+            appendLine(result, lineNumber, firstRange);
+        }
+        counted = lineEnd;
     }
-
-    return result;
 }
 
-QString FileSearchWorker::highlightMatches(const QString& line, const QRegularExpression& pattern) {
-    qInfo() << "highlightMatches input line: " << line;
-    QString highlighted;
-    int lastIndex = 0; // Track the last processed index in the line
+// Regex matches, one line at a time as before, but lines are cut from the mapped bytes and
+// with a `prefilter` only the lines holding its literal are decoded and matched
+void FileSearchWorker::searchLines(QByteArrayView bytes, const QRegularExpression& pattern,
+                                   const LiteralSearch* prefilter, FileSearchResults& result) {
+    const char* data = bytes.data();
+    const qint64 size = bytes.size();
 
-    // Find all matches in the line
-    QRegularExpressionMatchIterator it = pattern.globalMatch(line);
-    while (it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
+    int lineNumber = 0;
+    qint64 counted = 0;
+    qint64 from = 0;        // Start of the first line not looked at yet
+    while (from < size && !isCanceled()) {
+        qint64 lineStart = from;
+        if (prefilter) {
+            const qint64 candidate = prefilter->indexIn(data, size, from);
+            if (candidate < 0) break;
+            lineStart = candidate;
+            while (lineStart > from && data[lineStart - 1] != '\n') --lineStart;
+        }
+        lineNumber += int(std::count(data + counted, data + lineStart, '\n'));
+        counted = lineStart;
 
-        // Append text from the last index to the current match start
-        highlighted.append(line.mid(lastIndex, match.capturedStart(0) - lastIndex));
+        const char* newline = static_cast<const char*>(memchr(data + lineStart, '\n', size_t(size - lineStart)));
+        const qint64 lineEnd = newline ? newline - data : size;
+        const qint64 textEnd = lineEnd > lineStart && data[lineEnd - 1] == '\r' ? lineEnd - 1 : lineEnd;
+
+        const int firstRange = int(result.ranges.size());
+        if (collectMatches(QString::fromUtf8(data + lineStart, textEnd - lineStart), pattern, result) > 0) {
+            appendLine(result, lineNumber, firstRange);
+        }
+        from = lineEnd + 1;
+    }
+}
 
-        // Wrap the matched text with <highlight> tags
-        highlighted.append(QStringLiteral("<highlight>%1</highlight>").arg(match.captured(0)));
+// Decoded line by line, for text the byte-level paths cannot read
+void FileSearchWorker::searchStream(QTextStream& in, FileSearchResults& result) {
+    const QRegularExpression pattern = PatternCache::instance().pattern(m_options);
+    if (!pattern.isValid()) return;
 
-        // Update the last processed index
-        lastIndex = match.capturedEnd(0);
+    int lineNumber = 0;
+    while (!in.atEnd() && !isCanceled()) {
+        const int firstRange = int(result.ranges.size());
+        if (collectMatches(in.readLine(), pattern, result) > 0) {
+            appendLine(result, lineNumber, firstRange);
+        }
+        lineNumber++;
     }
+}
+
+// All keywords in one pass per line, counting which of them matched
+void FileSearchWorker::searchKeywordList(QTextStream& in, FileSearchResults& result) {
+    const QSharedPointer<const KeywordList> keywordList = m_keywordList ? m_keywordList
+                                                                        : PatternCache::instance().keywordList(m_options);
+    if (keywordList->isEmpty()) return;
+
+    int lineNumber = 0;
+    while (!in.atEnd() && !isCanceled()) {
+        const QString line = in.readLine();
+        const QVector<KeywordList::Match> found = keywordList->findAll(line, m_options.matchWholeWord);
 
-    // Append any remaining text after the last match
-    highlighted.append(line.mid(lastIndex));
-    qInfo() << "highlightMatches output line: " << line;
+        if (!found.isEmpty()) {
+            const int firstRange = int(result.ranges.size());
+            for (const KeywordList::Match& match : found) {
+                result.ranges.append(qMakePair(int(match.position), int(match.length)));
+                ++result.keywordCounts[keywordList->keywords().at(match.keyword)];
+            }
+            appendLine(result, lineNumber, firstRange);
+        }
 
-    return highlighted;
+        lineNumber++;
+    }
 }
 
+// Appends the range of every match in `line` and returns how many there were
+int FileSearchWorker::collectMatches(const QString& line, const QRegularExpression& pattern, FileSearchResults& result) {
+    int matches = 0;
+    QRegularExpressionMatchIterator it = pattern.globalMatch(line);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        result.ranges.append(qMakePair(int(match.capturedStart(0)), int(match.capturedLength(0))));
+        ++matches;
+    }
+    return matches;
+}
+
+// The line once, owning the ranges appended since `firstRange`
+void FileSearchWorker::appendLine(FileSearchResults& result, int lineNumber, int firstRange) {
+    const int matches = int(result.ranges.size()) - firstRange;
+    result.lines.append({lineNumber, firstRange, matches});
+    result.matchCount += matches;
+}
@@ -1,25 +1,60 @@
 #pragma once
 
+#include <QByteArrayView>
 #include <QObject>
 #include <QRunnable>
 #include <QRegularExpression>
-#include <QMimeDatabase>
+#include <QSharedPointer>
+#include <memory>
+#include "boundedqueue.h"
+#include "resultqueue.h"
+#include "searchcontrol.h"
 #include "searchoptions.h"
 
+class KeywordList;
+class LiteralSearch;
+class QTextStream;
+
 class FileSearchWorker : public QObject, public QRunnable {
     Q_OBJECT
 
 public:
     FileSearchWorker(const QString& filePath, const SearchOptions& options);
+
+    // Searches paths from `paths` until it is closed and drained
+    FileSearchWorker(const std::shared_ptr<BoundedQueue<QString>>& paths, const SearchOptions& options);
     void run() override;
 
+    // Results go to `results` instead of fileProcessed()
+    void setResultQueue(const std::shared_ptr<ResultQueue>& results);
+
+    // Stops when `control` is canceled, and counts files, bytes and matches into it
+    void setControl(const std::shared_ptr<SearchControl>& control);
+
+    // The automaton of a keyword list search, built once for all workers; looked up per file when unset
+    void setKeywordList(const QSharedPointer<const KeywordList>& keywordList);
+
 signals:
     void fileProcessed(const FileSearchResults& result);
+    void filesSearched(int count);  // Progress in queue mode, every few files
 
 private:
+    bool isCanceled() const;
+    void searchFile();
     FileSearchResults searchInFile();
-    QString highlightMatches(const QString& line, const QRegularExpression& pattern);
+    void searchLiteral(QByteArrayView bytes, const LiteralSearch& literal, FileSearchResults& result);
+    void searchLines(QByteArrayView bytes, const QRegularExpression& pattern, const LiteralSearch* prefilter,
+                     FileSearchResults& result);
+    void searchStream(QTextStream& in, FileSearchResults& result);
+    void searchKeywordList(QTextStream& in, FileSearchResults& result);
+
+    static int collectMatches(const QString& line, const QRegularExpression& pattern, FileSearchResults& result);
+    static void appendLine(FileSearchResults& result, int lineNumber, int firstRange);
 
     QString m_filePath;
     SearchOptions m_options;
+    std::shared_ptr<BoundedQueue<QString>> m_paths;
+    std::shared_ptr<ResultQueue> m_results;
+    std::shared_ptr<SearchControl> m_control;
+    QSharedPointer<const KeywordList> m_keywordList;
 };
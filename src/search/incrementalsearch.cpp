@@ -0,0 +1,190 @@
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QtConcurrent>
+#include <algorithm>
+#include "incrementalsearch.h"
+#include "search.h"
+#include "../codeeditor.h"
+
+IncrementalSearch::IncrementalSearch(QObject* parent)
+    : QObject(parent) {
+}
+
+IncrementalSearch::~IncrementalSearch() {
+    cancel();
+}
+
+void IncrementalSearch::setEditor(CodeEditor* editor) {
+    if (m_editor == editor) return;
+
+    cancel();
+    m_editor = editor;
+    m_text.clear();
+    m_textRevision = -1;
+    m_lastMatches.clear();
+    m_lastRevision = -1;
+    m_anchor = -1;
+}
+
+void IncrementalSearch::cancel() {
+    ++m_generation;
+    if (m_future.isRunning()) {
+        m_future.cancel();
+    }
+}
+
+void IncrementalSearch::update(const SearchOptions& options) {
+    cancel();
+    if (!m_editor) return;
+
+    if (options.keyword.isEmpty()) {
+        m_editor->clearSearchMatches();
+        m_text.clear(); // Don't hold a copy of the document between searches
+        m_textRevision = -1;
+        m_lastMatches.clear();
+        m_lastRevision = -1;
+        m_anchor = -1;
+        return;
+    }
+
+    if (m_anchor < 0) {
+        m_anchor = m_editor->textCursor().selectionStart();
+    }
+    m_anchor = qMin(m_anchor, m_editor->document()->characterCount() - 1); // Text may have shrunk
+
+    m_selected = selectInViewport(options);
+    if (!m_selected) {
+        // Drop the selection left by the shorter query until the full results arrive
+        QTextCursor cursor = m_editor->textCursor();
+        cursor.setPosition(m_anchor);
+        m_editor->setTextCursor(cursor);
+    }
+
+    // The snapshot is only retaken after an edit, not on every keystroke
+    QTextDocument* document = m_editor->document();
+    const int revision = document->revision();
+    if (m_textRevision != revision) {
+        m_text = document->toPlainText();
+        m_textRevision = revision;
+    }
+
+    const QString literal = Search::literalKeyword(options);
+    if (canNarrow(literal, options, revision)) {
+        const Qt::CaseSensitivity caseSensitivity = options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        m_future = QtConcurrent::run(&IncrementalSearch::narrow, m_text, m_lastMatches, literal, caseSensitivity);
+    } else {
+        m_future = QtConcurrent::run(&ParallelSearch::run, m_text, options);
+    }
+
+    const int generation = m_generation;
+    m_future.then(this, [this, generation, revision, options](QFuture<Matches> future) {
+        if (generation != m_generation || future.resultCount() == 0 || !m_editor) {
+            return; // Superseded by a newer keystroke
+        }
+        if (m_editor->document()->revision() != revision) {
+            return; // Edited meanwhile, the offsets no longer apply
+        }
+
+        m_lastOptions = options;
+        m_lastMatches = future.result();
+        m_lastRevision = revision;
+
+        m_editor->setSearchMatches(m_lastMatches);
+        if (!m_selected) {
+            selectFrom(m_lastMatches);
+        }
+    });
+}
+
+// Searches only the blocks on screen, read straight from the document
+bool IncrementalSearch::selectInViewport(const SearchOptions& options) {
+    CodeEditor* editor = m_editor;
+    QTextBlock block = editor->cursorForPosition(QPoint(0, 0)).block();
+    const QTextBlock last = editor->cursorForPosition(
+        QPoint(editor->viewport()->width() - 1, editor->viewport()->height() - 1)).block();
+
+    const int base = block.position();
+    QString visible;
+    for (; block.isValid(); block = block.next()) {
+        visible += block.text();
+        visible += QLatin1Char('\n');
+        if (block == last) break;
+    }
+
+    const Matches matches = ParallelSearch::findInRange(visible, {0, visible.size()}, options);
+    for (const QPair<int, int>& match : matches) {
+        if (base + match.first < m_anchor) continue;
+
+        QTextCursor cursor(editor->document());
+        cursor.setPosition(base + match.first);
+        cursor.setPosition(base + match.second, QTextCursor::KeepAnchor);
+        editor->setTextCursor(cursor);
+        return true;
+    }
+    return false;
+}
+
+// Selects the first match at or after the anchor, wrapping to the top of the document
+void IncrementalSearch::selectFrom(const Matches& matches) {
+    if (matches.isEmpty()) return;
+
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), m_anchor,
+                               [](const QPair<int, int>& match, int position) { return match.first < position; });
+    if (it == matches.cend()) {
+        it = matches.cbegin();
+    }
+
+    QTextCursor cursor(m_editor->document());
+    cursor.setPosition(it->first);
+    cursor.setPosition(it->second, QTextCursor::KeepAnchor);
+    m_editor->setTextCursor(cursor);
+    m_selected = true;
+}
+
+// A literal that extends the previous one can only match where the previous one did.
+// Whole-word matching is excluded: the longer word may end where the shorter one did not.
+// So is a previous literal with a border (a prefix that is also a suffix, as in "aa"):
+// its occurrences can overlap, and the non-overlapping scan behind m_lastMatches skipped
+// some of them.
+bool IncrementalSearch::canNarrow(const QString& literal, const SearchOptions& options, int revision) const {
+    if (literal.isEmpty() || revision != m_lastRevision || options.matchWholeWord || m_lastOptions.matchWholeWord) {
+        return false;
+    }
+    if (options.findMethod != m_lastOptions.findMethod || options.matchCase != m_lastOptions.matchCase) {
+        return false;
+    }
+
+    const QString previous = Search::literalKeyword(m_lastOptions);
+    const Qt::CaseSensitivity caseSensitivity = options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    return !previous.isEmpty() && literal.startsWith(previous, caseSensitivity) && !hasBorder(previous, caseSensitivity);
+}
+
+bool IncrementalSearch::hasBorder(const QString& literal, Qt::CaseSensitivity caseSensitivity) {
+    const QStringView view(literal);
+    for (qsizetype length = 1; length < view.size(); ++length) {
+        if (view.first(length).compare(view.last(length), caseSensitivity) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IncrementalSearch::narrow(QPromise<Matches>& promise, const QString& text, const Matches& previous,
+                               const QString& literal, Qt::CaseSensitivity caseSensitivity) {
+    Matches matches;
+    const QStringView view(text);
+
+    for (qsizetype i = 0; i < previous.size(); ++i) {
+        if ((i & 0xfff) == 0 && promise.isCanceled()) {
+            return;
+        }
+        const int start = previous.at(i).first;
+        if (!matches.isEmpty() && start < matches.last().second) {
+            continue;  // The longer literal may overlap itself; the full scan skips those too
+        }
+        if (view.mid(start, literal.size()).compare(literal, caseSensitivity) == 0) {
+            matches.append(qMakePair(start, int(start + literal.size())));
+        }
+    }
+    promise.addResult(std::move(matches));
+}
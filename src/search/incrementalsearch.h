@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include "parallelsearch.h"
+#include "searchoptions.h"
+
+class CodeEditor;
+
+// Find-as-you-type for the Find and Replace dialogs. Each keystroke first selects a match
+// among the lines on screen, synchronously, so it shows up in the next frame. The full
+// match index is then built on the thread pool; a newer keystroke cancels that run, and
+// a literal query that extends the previous one only re-checks the previous matches.
+class IncrementalSearch : public QObject {
+    Q_OBJECT
+
+public:
+    explicit IncrementalSearch(QObject* parent = nullptr);
+    ~IncrementalSearch();
+
+    void setEditor(CodeEditor* editor);
+
+    // Searches for `options.keyword`; an empty keyword clears the matches
+    void update(const SearchOptions& options);
+    void cancel();
+
+private:
+    using Matches = ParallelSearch::Matches;
+
+    bool selectInViewport(const SearchOptions& options);
+    void selectFrom(const Matches& matches);
+    bool canNarrow(const QString& literal, const SearchOptions& options, int revision) const;
+    static bool hasBorder(const QString& literal, Qt::CaseSensitivity caseSensitivity);
+    static void narrow(QPromise<Matches>& promise, const QString& text, const Matches& previous,
+                       const QString& literal, Qt::CaseSensitivity caseSensitivity);
+
+    QPointer<CodeEditor> m_editor;
+    QFuture<Matches> m_future;
+    int m_generation = 0;           // Bumped per query, so stale results are dropped
+
+    QString m_text;                 // Document snapshot, reused until the next edit
+    int m_textRevision = -1;
+
+    SearchOptions m_lastOptions;    // Query behind m_lastMatches
+    Matches m_lastMatches;
+    int m_lastRevision = -1;        // Revision m_lastMatches belongs to, -1 if none
+
+    int m_anchor = -1;              // Cursor position when typing started
+    bool m_selected = false;        // A match is already selected for this query
+};
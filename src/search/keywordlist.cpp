@@ -0,0 +1,236 @@
+#include <QChar>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include "keywordlist.h"
+#include "literalsearch.h"
+
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define KEYWORDLIST_SSE2
+#endif
+
+namespace {
+
+constexpr int kUnitCount = 0x10000;
+constexpr int kMaxSimdStartUnits = 8;  // Compares per block before the bitmap is cheaper
+
+// Simple case folding keeps lengths, so positions in folded and original text agree
+char16_t fold(char16_t unit, Qt::CaseSensitivity caseSensitivity) {
+    if (caseSensitivity == Qt::CaseSensitive) return unit;
+    const char32_t folded = QChar::toCaseFolded(char32_t(unit));
+    return folded <= 0xFFFF ? char16_t(folded) : unit;
+}
+
+}
+
+KeywordList::KeywordList(const QStringList& keywords, Qt::CaseSensitivity caseSensitivity) {
+    for (const QString& keyword : keywords) {
+        if (!keyword.isEmpty()) {
+            m_keywords.append(keyword);
+            m_lengths.append(int(keyword.size()));
+            m_maxLength = qMax(m_maxLength, int(keyword.size()));
+        }
+    }
+
+    // Columns only for units that occur in a keyword; everything else resets to the root
+    QVector<quint16> foldedClasses(kUnitCount, 0);
+    for (const QString& keyword : std::as_const(m_keywords)) {
+        for (QChar ch : keyword) {
+            quint16& unitClass = foldedClasses[fold(ch.unicode(), caseSensitivity)];
+            if (unitClass == 0) unitClass = quint16(m_width++);
+        }
+    }
+    m_classes.resize(kUnitCount);
+    for (int unit = 0; unit < kUnitCount; ++unit) {
+        m_classes[unit] = foldedClasses[fold(char16_t(unit), caseSensitivity)];
+    }
+
+    // Trie, with -1 for missing edges
+    m_delta = QVector<qint32>(m_width, -1);
+    m_output = {-1};
+    for (int k = 0; k < m_keywords.size(); ++k) {
+        int state = 0;
+        for (QChar ch : m_keywords.at(k)) {
+            const int unitClass = classOf(ch.unicode());
+            int target = next(state, unitClass);
+            if (target < 0) {
+                target = int(m_output.size());
+                m_delta[state * m_width + unitClass] = target;
+                m_delta.append(QVector<qint32>(m_width, -1));
+                m_output.append(-1);
+            }
+            state = target;
+        }
+        if (m_output[state] < 0) {
+            m_output[state] = k;  // Equal keywords report the first one
+        }
+    }
+
+    // Breadth first, so a state's failure target is complete before its own edges are
+    const int states = int(m_output.size());
+    QVector<qint32> failure(states, 0);
+    m_outputLink = QVector<qint32>(states, -1);
+    QVector<int> queue;
+    queue.reserve(states);
+    for (int unitClass = 0; unitClass < m_width; ++unitClass) {
+        qint32& target = m_delta[unitClass];
+        if (target < 0) {
+            target = 0;
+        } else {
+            queue.append(target);
+        }
+    }
+    for (qsizetype head = 0; head < queue.size(); ++head) {
+        const int state = queue.at(head);
+        for (int unitClass = 0; unitClass < m_width; ++unitClass) {
+            const int fallback = next(failure[state], unitClass);
+            qint32& target = m_delta[state * m_width + unitClass];
+            if (target < 0) {
+                target = fallback;
+            } else {
+                failure[target] = fallback;
+                m_outputLink[target] = m_output[fallback] >= 0 ? fallback : m_outputLink[fallback];
+                queue.append(target);
+            }
+        }
+    }
+
+    // Units that can begin a keyword, for skipping ahead while at the root
+    m_startBits = QVector<quint64>(kUnitCount / 64, 0);
+    for (int unit = 0; unit < kUnitCount; ++unit) {
+        const int unitClass = m_classes[unit];
+        if (unitClass != 0 && next(0, unitClass) != 0) {
+            m_startBits[unit / 64] |= quint64(1) << (unit % 64);
+            if (m_startUnits.size() <= kMaxSimdStartUnits) {
+                m_startUnits.append(char16_t(unit));
+            }
+        }
+    }
+    if (m_startUnits.size() > kMaxSimdStartUnits) {
+        m_startUnits.clear();
+    }
+}
+
+bool KeywordList::isEmpty() const {
+    return m_keywords.isEmpty();
+}
+
+const QStringList& KeywordList::keywords() const {
+    return m_keywords;
+}
+
+QVector<KeywordList::Match> KeywordList::findAll(QStringView text, bool wholeWord) const {
+    QVector<Match> matches;
+    if (isEmpty()) return matches;
+
+    const char16_t* data = text.utf16();
+    const qsizetype size = text.size();
+    qsizetype lastEnd = 0;
+
+    // Matches found but not yet chosen. The leftmost one is final once no later match can
+    // start at or before it, i.e. once the scan is m_maxLength units past its start.
+    QVector<Match> window;
+    auto settle = [&](qsizetype position) {
+        while (!window.isEmpty()) {
+            qsizetype best = 0;
+            for (qsizetype j = 1; j < window.size(); ++j) {
+                const Match& candidate = window.at(j);
+                if (candidate.position < window.at(best).position ||
+                    (candidate.position == window.at(best).position && candidate.length > window.at(best).length)) {
+                    best = j;
+                }
+            }
+            if (position - window.at(best).position < m_maxLength) return;
+
+            const Match chosen = window.at(best);
+            matches.append(chosen);
+            lastEnd = chosen.position + chosen.length;
+            window.removeIf([lastEnd](const Match& match) { return match.position < lastEnd; });
+        }
+    };
+
+    int state = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        if (state == 0) {
+            i = nextStart(data, size, i);
+            if (i >= size) break;
+        }
+        if (!window.isEmpty()) settle(i);
+
+        state = next(state, classOf(data[i]));
+
+        // Every keyword ending here, longest first
+        for (int node = m_output[state] >= 0 ? state : m_outputLink[state]; node >= 0; node = m_outputLink[node]) {
+            const int keyword = m_output[node];
+            const qsizetype length = m_lengths[keyword];
+            const qsizetype start = i + 1 - length;
+            if (start < lastEnd) continue;
+            if (wholeWord && !LiteralSearch::isWholeWord(text, start, length)) continue;
+            window.append({start, length, keyword});
+        }
+    }
+    settle(size + m_maxLength);
+    return matches;
+}
+
+// First position at or after `from` holding a unit that can start a keyword, or `size`
+qsizetype KeywordList::nextStart(const char16_t* data, qsizetype size, qsizetype from) const {
+    qsizetype i = from;
+
+#ifdef KEYWORDLIST_SSE2
+    if (!m_startUnits.isEmpty()) {
+        __m128i accepted[kMaxSimdStartUnits];
+        const int count = int(m_startUnits.size());
+        for (int k = 0; k < count; ++k) {
+            accepted[k] = _mm_set1_epi16(static_cast<short>(m_startUnits.at(k)));
+        }
+        for (; i + 8 <= size; i += 8) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hits = _mm_cmpeq_epi16(block, accepted[0]);
+            for (int k = 1; k < count; ++k) {
+                hits = _mm_or_si128(hits, _mm_cmpeq_epi16(block, accepted[k]));
+            }
+            const quint32 mask = static_cast<quint32>(_mm_movemask_epi8(hits));
+            if (mask) return i + qCountTrailingZeroBits(mask) / 2;
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        const char16_t unit = data[i];
+        if (m_startBits[unit / 64] & (quint64(1) << (unit % 64))) return i;
+    }
+    return size;
+}
+
+QStringList KeywordList::parse(const QString& text) {
+    QStringList candidates;
+    const QFileInfo info(text);
+    if (!text.isEmpty() && info.isFile()) {
+        QFile file(text);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&file);
+            while (!in.atEnd()) {
+                candidates.append(in.readLine().trimmed());
+            }
+        }
+    } else {
+        static const QRegularExpression separators(QStringLiteral("[\\s,]+"));
+        candidates = text.split(separators, Qt::SkipEmptyParts);
+    }
+
+    QStringList keywords;
+    QSet<QString> seen;
+    for (const QString& keyword : std::as_const(candidates)) {
+        if (!keyword.isEmpty() && !seen.contains(keyword)) {
+            seen.insert(keyword);
+            keywords.append(keyword);
+        }
+    }
+    return keywords;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+
+// Searches for any of a list of keywords in one pass (Aho-Corasick). The trie is compiled
+// into a dense state table over the code units that occur in the keywords, so scanning
+// is one table lookup per unit with no backtracking. While no keyword is in progress,
+// the scan skips ahead to the next unit that can start one, eight units at a time with
+// SSE2 when few distinct units can. Immutable once built, so threads can share it.
+class KeywordList {
+public:
+    struct Match {
+        qsizetype position;
+        qsizetype length;
+        int keyword;        // Index into keywords()
+    };
+
+    KeywordList(const QStringList& keywords, Qt::CaseSensitivity caseSensitivity);
+
+    bool isEmpty() const;
+    const QStringList& keywords() const;
+
+    // Leftmost-longest, non-overlapping matches in `text`, in order
+    QVector<Match> findAll(QStringView text, bool wholeWord = false) const;
+
+    // Keywords from the find box: the lines of a file when `text` names one, otherwise
+    // words separated by whitespace or commas. Duplicates are dropped.
+    static QStringList parse(const QString& text);
+
+private:
+    int classOf(char16_t unit) const { return m_classes[unit]; }
+    int next(int state, int unitClass) const { return m_delta[state * m_width + unitClass]; }
+    qsizetype nextStart(const char16_t* data, qsizetype size, qsizetype from) const;
+
+    QStringList m_keywords;
+    QVector<int> m_lengths;
+    int m_maxLength = 0;
+
+    QVector<quint16> m_classes;     // Code unit -> column in m_delta, 0 for units in no keyword
+    int m_width = 1;
+    QVector<qint32> m_delta;        // Complete transition table, m_width columns per state
+    QVector<qint32> m_output;       // Longest keyword ending in a state, or -1
+    QVector<qint32> m_outputLink;   // Nearest shorter suffix state with an output, or -1
+
+    QVector<char16_t> m_startUnits; // Units that leave the root state, when there are few
+    QVector<quint64> m_startBits;   // The same as a bitmap over all code units
+};
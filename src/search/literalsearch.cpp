@@ -0,0 +1,350 @@
+#include <QtAlgorithms>
+#include <cstring>
+#include "literalsearch.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#define LITERALSEARCH_X86
+#endif
+
+#if defined(LITERALSEARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LITERALSEARCH_AVX2_DISPATCH
+#endif
+
+#if defined(LITERALSEARCH_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LITERALSEARCH_SSE2
+#endif
+
+namespace {
+
+template <typename Unit>
+using Anchors = LiteralSearch::Anchors<Unit>;
+
+// movemask yields one bit per byte; for UTF-16 keep one bit per code unit
+template <typename Unit>
+constexpr quint32 unitBits() {
+    return sizeof(Unit) == 1 ? 0xFFFFFFFFu : 0x55555555u;
+}
+
+template <typename Unit>
+inline bool isAnchor(Unit value, const Unit (&accepted)[2]) {
+    return value == accepted[0] || value == accepted[1];
+}
+
+// Checks the candidates in `mask` (bit k marks position + k / sizeof(Unit)) in order
+template <typename Unit, typename Verify>
+inline bool firstVerified(quint32 mask, qint64 position, const Verify &verify, qint64 &match) {
+    while (mask) {
+        const qint64 candidate = position + qCountTrailingZeroBits(mask) / sizeof(Unit);
+        if (verify(candidate)) {
+            match = candidate;
+            return true;
+        }
+        mask &= mask - 1;
+    }
+    return false;
+}
+
+template <typename Unit, typename Verify>
+inline bool lastVerified(quint32 mask, qint64 position, const Verify &verify, qint64 &match) {
+    while (mask) {
+        const int bit = 31 - qCountLeadingZeroBits(mask);
+        const qint64 candidate = position + bit / sizeof(Unit);
+        if (verify(candidate)) {
+            match = candidate;
+            return true;
+        }
+        mask &= ~(1u << bit);
+    }
+    return false;
+}
+
+#ifdef LITERALSEARCH_SSE2
+template <typename Unit>
+inline quint32 candidatesSse2(const Unit *head, const Unit *tail, const Anchors<Unit> &anchors) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(head));
+    const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tail));
+    __m128i first;
+    __m128i last;
+    if constexpr (sizeof(Unit) == 1) {
+        first = _mm_or_si128(_mm_cmpeq_epi8(h, _mm_set1_epi8(anchors.first[0])),
+                             _mm_cmpeq_epi8(h, _mm_set1_epi8(anchors.first[1])));
+        last = _mm_or_si128(_mm_cmpeq_epi8(t, _mm_set1_epi8(anchors.last[0])),
+                            _mm_cmpeq_epi8(t, _mm_set1_epi8(anchors.last[1])));
+    } else {
+        first = _mm_or_si128(_mm_cmpeq_epi16(h, _mm_set1_epi16(static_cast<short>(anchors.first[0]))),
+                             _mm_cmpeq_epi16(h, _mm_set1_epi16(static_cast<short>(anchors.first[1]))));
+        last = _mm_or_si128(_mm_cmpeq_epi16(t, _mm_set1_epi16(static_cast<short>(anchors.last[0]))),
+                            _mm_cmpeq_epi16(t, _mm_set1_epi16(static_cast<short>(anchors.last[1]))));
+    }
+    return static_cast<quint32>(_mm_movemask_epi8(_mm_and_si128(first, last))) & unitBits<Unit>();
+}
+#endif
+
+#ifdef LITERALSEARCH_AVX2_DISPATCH
+template <typename Unit>
+__attribute__((target("avx2"))) inline quint32 candidatesAvx2(const Unit *head, const Unit *tail,
+                                                              const Anchors<Unit> &anchors) {
+    const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(head));
+    const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail));
+    __m256i first;
+    __m256i last;
+    if constexpr (sizeof(Unit) == 1) {
+        first = _mm256_or_si256(_mm256_cmpeq_epi8(h, _mm256_set1_epi8(anchors.first[0])),
+                                _mm256_cmpeq_epi8(h, _mm256_set1_epi8(anchors.first[1])));
+        last = _mm256_or_si256(_mm256_cmpeq_epi8(t, _mm256_set1_epi8(anchors.last[0])),
+                               _mm256_cmpeq_epi8(t, _mm256_set1_epi8(anchors.last[1])));
+    } else {
+        first = _mm256_or_si256(_mm256_cmpeq_epi16(h, _mm256_set1_epi16(static_cast<short>(anchors.first[0]))),
+                                _mm256_cmpeq_epi16(h, _mm256_set1_epi16(static_cast<short>(anchors.first[1]))));
+        last = _mm256_or_si256(_mm256_cmpeq_epi16(t, _mm256_set1_epi16(static_cast<short>(anchors.last[0]))),
+                               _mm256_cmpeq_epi16(t, _mm256_set1_epi16(static_cast<short>(anchors.last[1]))));
+    }
+    return static_cast<quint32>(_mm256_movemask_epi8(_mm256_and_si256(first, last))) & unitBits<Unit>();
+}
+
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+// First verified match in [from, size - length], or -1
+template <typename Unit, typename Verify>
+qint64 findForward(const Unit *data, qint64 size, qint64 from, qint64 length,
+                   const Anchors<Unit> &anchors, const Verify &verify) {
+    const qint64 lastStart = size - length;
+    qint64 i = qMax<qint64>(0, from);
+    qint64 match = -1;
+
+#ifdef LITERALSEARCH_AVX2_DISPATCH
+    if (hasAvx2()) {
+        constexpr qint64 lanes = 32 / sizeof(Unit);
+        for (; i + lanes - 1 <= lastStart; i += lanes) {
+            const quint32 mask = candidatesAvx2(data + i, data + i + length - 1, anchors);
+            if (firstVerified<Unit>(mask, i, verify, match)) return match;
+        }
+    }
+#endif
+#ifdef LITERALSEARCH_SSE2
+    constexpr qint64 lanes = 16 / sizeof(Unit);
+    for (; i + lanes - 1 <= lastStart; i += lanes) {
+        const quint32 mask = candidatesSse2(data + i, data + i + length - 1, anchors);
+        if (firstVerified<Unit>(mask, i, verify, match)) return match;
+    }
+#endif
+
+    for (; i <= lastStart; ++i) {
+        if (isAnchor(data[i], anchors.first) && isAnchor(data[i + length - 1], anchors.last) && verify(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Last verified match starting in [0, min(from, size - length)], or -1
+template <typename Unit, typename Verify>
+qint64 findBackward(const Unit *data, qint64 size, qint64 from, qint64 length,
+                    const Anchors<Unit> &anchors, const Verify &verify) {
+    qint64 i = qMin(from, size - length);  // Highest start not checked yet
+    qint64 match = -1;
+
+#ifdef LITERALSEARCH_AVX2_DISPATCH
+    if (hasAvx2()) {
+        constexpr qint64 lanes = 32 / sizeof(Unit);
+        for (; i - lanes + 1 >= 0; i -= lanes) {
+            const qint64 base = i - lanes + 1;
+            const quint32 mask = candidatesAvx2(data + base, data + base + length - 1, anchors);
+            if (lastVerified<Unit>(mask, base, verify, match)) return match;
+        }
+    }
+#endif
+#ifdef LITERALSEARCH_SSE2
+    constexpr qint64 lanes = 16 / sizeof(Unit);
+    for (; i - lanes + 1 >= 0; i -= lanes) {
+        const qint64 base = i - lanes + 1;
+        const quint32 mask = candidatesSse2(data + base, data + base + length - 1, anchors);
+        if (lastVerified<Unit>(mask, base, verify, match)) return match;
+    }
+#endif
+
+    for (; i >= 0; --i) {
+        if (isAnchor(data[i], anchors.first) && isAnchor(data[i + length - 1], anchors.last) && verify(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Letters and digits of any script and '_', as \b sees them with Unicode properties on
+inline bool isWordCharacter(char32_t ch) {
+    return ch == '_' || QChar::isLetterOrNumber(ch);
+}
+
+// Code point ending just before / starting at `index`, or 0 outside the text
+char32_t codePointBefore(QStringView text, qsizetype index) {
+    if (index <= 0 || index > text.size()) return 0;
+    const QChar low = text.at(index - 1);
+    if (low.isLowSurrogate() && index >= 2 && text.at(index - 2).isHighSurrogate()) {
+        return QChar::surrogateToUcs4(text.at(index - 2), low);
+    }
+    return low.unicode();
+}
+
+char32_t codePointAt(QStringView text, qsizetype index) {
+    if (index < 0 || index >= text.size()) return 0;
+    const QChar high = text.at(index);
+    if (high.isHighSurrogate() && index + 1 < text.size() && text.at(index + 1).isLowSurrogate()) {
+        return QChar::surrogateToUcs4(high, text.at(index + 1));
+    }
+    return high.unicode();
+}
+
+// The same on UTF-8 bytes; malformed sequences decode to U+FFFD, which is not a word character
+char32_t utf8CodePointAt(const char *data, qint64 end, qint64 position) {
+    if (position < 0 || position >= end) return 0;
+    const uchar lead = static_cast<uchar>(data[position]);
+    if (lead < 0x80) return lead;
+
+    const int length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (length == 1 || position + length > end) return QChar::ReplacementCharacter;
+    char32_t ch = lead & (0x7F >> length);
+    for (int i = 1; i < length; ++i) {
+        ch = (ch << 6) | (static_cast<uchar>(data[position + i]) & 0x3F);
+    }
+    return ch;
+}
+
+char32_t utf8CodePointBefore(const char *data, qint64 begin, qint64 position) {
+    if (position <= begin) return 0;
+    qint64 start = position - 1;
+    while (start > begin && position - start < 4 && (static_cast<uchar>(data[start]) & 0xC0) == 0x80) {
+        --start;
+    }
+    return utf8CodePointAt(data, position, start);
+}
+
+inline char16_t asciiLower(char16_t ch) {
+    return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+}
+
+inline char16_t asciiUpper(char16_t ch) {
+    return (ch >= 'a' && ch <= 'z') ? ch - ('a' - 'A') : ch;
+}
+
+// Both ASCII cases of `ch`, or false when another character folds to it too
+// (U+212A KELVIN SIGN to 'k', U+017F LONG S to 's') or it is not ASCII at all
+template <typename Unit>
+bool foldedAnchor(char16_t ch, Unit (&accepted)[2]) {
+    const char16_t lower = asciiLower(ch);
+    if (ch >= 0x80 || lower == 'k' || lower == 's') return false;
+    accepted[0] = static_cast<Unit>(lower);
+    accepted[1] = static_cast<Unit>(asciiUpper(ch));
+    return true;
+}
+
+// True when an ASCII-only case fold finds every case variant of `needle`: no character
+// outside ASCII, and no 'k' or 's' that a non-ASCII character folds to
+bool foldsAsAscii(const QString &needle) {
+    for (const QChar ch : needle) {
+        const char16_t lower = asciiLower(ch.unicode());
+        if (ch.unicode() >= 0x80 || lower == 'k' || lower == 's') return false;
+    }
+    return true;
+}
+
+}
+
+LiteralSearch::LiteralSearch(const QString &needle, Qt::CaseSensitivity caseSensitivity)
+    : m_needle(needle), m_needleUtf8(needle.toUtf8()), m_caseSensitivity(caseSensitivity) {
+    if (m_needle.isEmpty()) return;
+
+    const char16_t first = m_needle.front().unicode();
+    const char16_t last = m_needle.back().unicode();
+
+    if (m_caseSensitivity == Qt::CaseSensitive) {
+        m_anchors16 = {{first, first}, {last, last}, true};
+        const char first8 = m_needleUtf8.front();
+        const char last8 = m_needleUtf8.back();
+        m_anchors8 = {{first8, first8}, {last8, last8}, true};
+    } else {
+        // Non-ASCII anchors have several case variants; those needles take QStringView::indexOf
+        m_anchors16.usable = foldedAnchor(first, m_anchors16.first) && foldedAnchor(last, m_anchors16.last);
+        // The UTF-8 comparison folds ASCII only, so all of the needle must be ASCII ("München"
+        // would miss "MÜNCHEN"); other needles go to the decoded paths
+        m_anchors8.usable = foldsAsAscii(m_needle) && foldedAnchor(first, m_anchors8.first)
+                            && foldedAnchor(last, m_anchors8.last);
+    }
+}
+
+bool LiteralSearch::isEmpty() const {
+    return m_needle.isEmpty();
+}
+
+qsizetype LiteralSearch::size() const {
+    return m_needle.size();
+}
+
+qint64 LiteralSearch::utf8Size() const {
+    return m_needleUtf8.size();
+}
+
+bool LiteralSearch::matchesAt(const char16_t *data, qsizetype position) const {
+    if (m_caseSensitivity == Qt::CaseSensitive) {
+        return std::memcmp(data + position, m_needle.utf16(), m_needle.size() * sizeof(char16_t)) == 0;
+    }
+    return QStringView(data + position, m_needle.size()).compare(m_needle, Qt::CaseInsensitive) == 0;
+}
+
+bool LiteralSearch::matchesAt(const char *data, qint64 position) const {
+    if (m_caseSensitivity == Qt::CaseSensitive) {
+        return std::memcmp(data + position, m_needleUtf8.constData(), m_needleUtf8.size()) == 0;
+    }
+    return qstrnicmp(data + position, m_needleUtf8.size(), m_needleUtf8.constData(), m_needleUtf8.size()) == 0;
+}
+
+qsizetype LiteralSearch::indexIn(QStringView text, qsizetype from) const {
+    if (isEmpty() || from > text.size() - size()) return -1;
+    if (!m_anchors16.usable) return text.indexOf(m_needle, qMax<qsizetype>(0, from), m_caseSensitivity);
+
+    const char16_t *data = text.utf16();
+    return findForward(data, text.size(), from, size(), m_anchors16,
+                       [this, data](qint64 position) { return matchesAt(data, position); });
+}
+
+qsizetype LiteralSearch::lastIndexIn(QStringView text, qsizetype from) const {
+    if (isEmpty() || from < 0 || text.size() < size()) return -1;
+    if (!m_anchors16.usable) return text.lastIndexOf(m_needle, qMin(from, text.size() - size()), m_caseSensitivity);
+
+    const char16_t *data = text.utf16();
+    return findBackward(data, text.size(), from, size(), m_anchors16,
+                        [this, data](qint64 position) { return matchesAt(data, position); });
+}
+
+bool LiteralSearch::supportsUtf8() const {
+    return !isEmpty() && m_anchors8.usable;
+}
+
+qint64 LiteralSearch::indexIn(const char *data, qint64 size, qint64 from) const {
+    if (!supportsUtf8() || from > size - utf8Size()) return -1;
+    return findForward(data, size, from, utf8Size(), m_anchors8,
+                       [this, data](qint64 position) { return matchesAt(data, position); });
+}
+
+qint64 LiteralSearch::lastIndexIn(const char *data, qint64 size, qint64 from) const {
+    if (!supportsUtf8() || from < 0 || size < utf8Size()) return -1;
+    return findBackward(data, size, from, utf8Size(), m_anchors8,
+                        [this, data](qint64 position) { return matchesAt(data, position); });
+}
+
+bool LiteralSearch::isWholeWord(QStringView text, qsizetype position, qsizetype length) {
+    const qsizetype end = position + length;
+    return isWordCharacter(codePointBefore(text, position)) != isWordCharacter(codePointAt(text, position))
+           && isWordCharacter(codePointBefore(text, end)) != isWordCharacter(codePointAt(text, end));
+}
+
+bool LiteralSearch::isWholeWord(const char *data, qint64 begin, qint64 end, qint64 position, qint64 length) {
+    const qint64 matchEnd = position + length;
+    return isWordCharacter(utf8CodePointBefore(data, begin, position)) != isWordCharacter(utf8CodePointAt(data, end, position))
+           && isWordCharacter(utf8CodePointBefore(data, begin, matchEnd)) != isWordCharacter(utf8CodePointAt(data, end, matchEnd));
+}
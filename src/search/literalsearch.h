@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringView>
+
+// Plain-text search without the regex engine. Candidate positions are found by comparing
+// the needle's first and last characters against 16-32 positions at once (AVX2 or SSE2
+// where available), and only those candidates are compared in full. Works on UTF-16
+// (QTextDocument blocks) and on UTF-8 (memory-mapped files, piece table chunks).
+class LiteralSearch {
+public:
+    LiteralSearch(const QString &needle, Qt::CaseSensitivity caseSensitivity);
+
+    bool isEmpty() const;
+    qsizetype size() const;      // In UTF-16 code units
+    qint64 utf8Size() const;     // In bytes
+
+    // First match starting at or after `from`, or the last one starting at or before it
+    qsizetype indexIn(QStringView text, qsizetype from = 0) const;
+    qsizetype lastIndexIn(QStringView text, qsizetype from) const;
+
+    // Case-insensitive UTF-8 search folds ASCII only, so it needs an ASCII needle without
+    // 'k' or 's' (which U+212A and U+017F fold to); false otherwise
+    bool supportsUtf8() const;
+    qint64 indexIn(const char *data, qint64 size, qint64 from = 0) const;
+    qint64 lastIndexIn(const char *data, qint64 size, qint64 from) const;
+
+    // Same boundaries as the \b the regex path uses (letters and digits of any script, and '_')
+    static bool isWholeWord(QStringView text, qsizetype position, qsizetype length);
+    // The same on UTF-8 bytes, with [begin, end) the text around the match (a line, a chunk)
+    static bool isWholeWord(const char *data, qint64 begin, qint64 end, qint64 position, qint64 length);
+
+    template <typename Unit>
+    struct Anchors {
+        Unit first[2];  // Accepted values of the first unit (both cases when folding)
+        Unit last[2];
+        bool usable = false;
+    };
+
+private:
+    bool matchesAt(const char16_t *data, qsizetype position) const;
+    bool matchesAt(const char *data, qint64 position) const;
+
+    QString m_needle;
+    QByteArray m_needleUtf8;
+    Qt::CaseSensitivity m_caseSensitivity;
+    Anchors<char16_t> m_anchors16;
+    Anchors<char> m_anchors8;
+};
@@ -0,0 +1,284 @@
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include "parallelsearch.h"
+#include "keywordlist.h"
+#include "literalsearch.h"
+#include "patterncache.h"
+#include "search.h"
+#include "../piecetable.h"
+
+namespace {
+
+constexpr qsizetype kMinChunkSize = 1024 * 1024; // Smaller chunks cost more in scheduling than they save
+constexpr int kChunksPerThread = 4;               // Slack so uneven chunks still balance
+constexpr qsizetype kKeywordBlockSize = 64 * 1024; // Keyword list text between cancel checks
+constexpr qint64 kByteChunkSize = 8 * 1024 * 1024;  // Piece table chunk, per thread and wave
+constexpr qint64 kWordContext = 4;                  // Bytes around a chunk for word boundaries
+
+int waveSize() {
+    return qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+}
+
+}
+
+ParallelSearch::Matches ParallelSearch::findAll(const QString& text, const SearchOptions& options,
+                                                const QPromise<Matches>* promise) {
+    QSharedPointer<const KeywordList> keywordList;
+    if (options.findMethod == FindMethod::KeywordList) {
+        keywordList = PatternCache::instance().keywordList(options);
+    }
+
+    const QVector<Range> ranges = splitLines(text);
+    if (ranges.size() == 1) {
+        return findInRange(text, ranges.first(), options, promise, keywordList.get());
+    }
+
+    // The calling thread takes part in the map, so this is safe from a pool thread too
+    const QList<Matches> parts = QtConcurrent::blockingMapped(ranges, [&](const Range& range) {
+        return findInRange(text, range, options, promise, keywordList.get());
+    });
+
+    qsizetype total = 0;
+    for (const Matches& part : parts) {
+        total += part.size();
+    }
+
+    Matches matches;
+    matches.reserve(total);
+    for (const Matches& part : parts) {
+        matches.append(part);
+    }
+    return matches;
+}
+
+void ParallelSearch::run(QPromise<Matches>& promise, const QString& text, const SearchOptions& options) {
+    Matches matches = findAll(text, options, &promise);
+    if (promise.isCanceled()) {
+        return;
+    }
+    promise.addResult(std::move(matches));
+}
+
+// Chunks end just past a '\n', so every line belongs to exactly one chunk
+QVector<ParallelSearch::Range> ParallelSearch::splitLines(const QString& text) {
+    const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const qsizetype chunkSize = qMax(kMinChunkSize, text.size() / (threads * kChunksPerThread));
+
+    QVector<Range> ranges;
+    qsizetype begin = 0;
+    while (text.size() - begin > chunkSize) {
+        const qsizetype newline = text.indexOf(QLatin1Char('\n'), begin + chunkSize);
+        if (newline < 0) break;
+        ranges.append({begin, newline + 1});
+        begin = newline + 1;
+    }
+    ranges.append({begin, text.size()});
+    return ranges;
+}
+
+ParallelSearch::Matches ParallelSearch::findInRange(const QString& text, Range range, const SearchOptions& options,
+                                                    const QPromise<Matches>* promise, const KeywordList* keywordList) {
+    Matches matches;
+    auto canceled = [promise]() { return promise && promise->isCanceled(); };
+
+    if (options.findMethod == FindMethod::KeywordList) {
+        QSharedPointer<const KeywordList> resolved;
+        if (!keywordList) {
+            resolved = PatternCache::instance().keywordList(options);
+            keywordList = resolved.get();
+        }
+
+        // Line-aligned blocks, so a cancel is noticed within one of them
+        qsizetype blockStart = range.begin;
+        while (blockStart < range.end && !canceled()) {
+            qsizetype blockEnd = range.end;
+            if (blockEnd - blockStart > kKeywordBlockSize) {
+                const qsizetype newline = text.indexOf(QLatin1Char('\n'), blockStart + kKeywordBlockSize);
+                if (newline >= 0 && newline < range.end) blockEnd = newline + 1;
+            }
+
+            const QStringView view = QStringView(text).mid(blockStart, blockEnd - blockStart);
+            for (const KeywordList::Match& match : keywordList->findAll(view, options.matchWholeWord)) {
+                const qsizetype start = blockStart + match.position;
+                matches.append(qMakePair(int(start), int(start + match.length)));
+            }
+            blockStart = blockEnd;
+        }
+        return matches;
+    }
+
+    const QString literal = Search::literalKeyword(options);
+    if (!literal.isEmpty()) {
+        const LiteralSearch literalSearch(literal, options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive);
+        const QStringView view = QStringView(text).first(range.end);
+        qsizetype index = literalSearch.indexIn(view, range.begin);
+        while (index >= 0 && !canceled()) {
+            if (options.matchWholeWord && !LiteralSearch::isWholeWord(text, index, literalSearch.size())) {
+                index = literalSearch.indexIn(view, index + 1);
+                continue;
+            }
+            matches.append(qMakePair(int(index), int(index + literalSearch.size())));
+            index = literalSearch.indexIn(view, index + literalSearch.size());
+        }
+        return matches;
+    }
+
+    const QRegularExpression regex = PatternCache::instance().pattern(options);
+    if (!regex.isValid()) {
+        return matches; // Invalid regex, nothing to highlight
+    }
+
+    // Line by line, like QTextDocument::find, so ^ and $ keep their per-line meaning
+    qsizetype lineStart = range.begin;
+    while (lineStart < range.end && !canceled()) {
+        qsizetype lineEnd = text.indexOf(QLatin1Char('\n'), lineStart);
+        if (lineEnd < 0 || lineEnd > range.end) lineEnd = range.end;
+
+        QRegularExpressionMatchIterator it = regex.globalMatch(text.mid(lineStart, lineEnd - lineStart));
+        while (it.hasNext()) {
+            const QRegularExpressionMatch match = it.next();
+            if (match.capturedLength() > 0) {
+                matches.append(qMakePair(int(lineStart + match.capturedStart()), int(lineStart + match.capturedEnd())));
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return matches;
+}
+
+ParallelSearch::ByteMatches ParallelSearch::findAll(const PieceTable& pieceTable, const LiteralSearch& literal,
+                                                    bool wholeWord, qsizetype limit) {
+    ByteMatches matches;
+    if (!literal.supportsUtf8()) return matches;
+
+    const qint64 size = pieceTable.size();
+    qint64 begin = 0;
+    while (begin < size && matches.size() < limit) {
+        QVector<ByteRange> wave;
+        for (int i = 0; i < waveSize() && begin < size; ++i) {
+            const qint64 end = qMin(size, begin + kByteChunkSize);
+            wave.append({begin, end});
+            begin = end;
+        }
+
+        const QList<ByteMatches> parts = searchWave(pieceTable, literal, wave, wholeWord, Scan::All,
+                                                    limit - matches.size());
+        for (qsizetype i = 0; i < parts.size() && matches.size() < limit; ++i) {
+            ByteMatches part = parts.at(i);
+            // A match running into this chunk hides the ones it overlaps, and a serial scan
+            // resumes at its end; rare enough to rescan the chunk from there
+            if (!matches.isEmpty() && !part.isEmpty() && part.first().first < matches.last().second) {
+                part = findInBytes(pieceTable, literal, {matches.last().second, wave.at(i).end}, wholeWord,
+                                   Scan::All, limit - matches.size());
+            }
+            matches.append(part.first(qMin(part.size(), limit - matches.size())));
+        }
+    }
+    return matches;
+}
+
+qint64 ParallelSearch::indexIn(const PieceTable& pieceTable, const LiteralSearch& literal, qint64 from,
+                               bool wholeWord) {
+    if (!literal.supportsUtf8()) return -1;
+
+    const qint64 size = pieceTable.size();
+    qint64 begin = qMax<qint64>(0, from);
+    while (begin < size) {
+        QVector<ByteRange> wave;
+        for (int i = 0; i < waveSize() && begin < size; ++i) {
+            const qint64 end = qMin(size, begin + kByteChunkSize);
+            wave.append({begin, end});
+            begin = end;
+        }
+
+        // The nearest chunk with a match wins; later waves are never read
+        for (const ByteMatches& part : searchWave(pieceTable, literal, wave, wholeWord, Scan::First, 1)) {
+            if (!part.isEmpty()) return part.first().first;
+        }
+    }
+    return -1;
+}
+
+qint64 ParallelSearch::lastIndexIn(const PieceTable& pieceTable, const LiteralSearch& literal, qint64 from,
+                                   bool wholeWord) {
+    if (!literal.supportsUtf8()) return -1;
+
+    qint64 end = qMin(from, pieceTable.size() - literal.utf8Size()) + 1;
+    while (end > 0) {
+        QVector<ByteRange> wave;
+        for (int i = 0; i < waveSize() && end > 0; ++i) {
+            const qint64 begin = qMax<qint64>(0, end - kByteChunkSize);
+            wave.append({begin, end});
+            end = begin;
+        }
+
+        for (const ByteMatches& part : searchWave(pieceTable, literal, wave, wholeWord, Scan::Last, 1)) {
+            if (!part.isEmpty()) return part.first().first;
+        }
+    }
+    return -1;
+}
+
+// Runs on the calling thread too; the table must not be edited until this returns
+QList<ParallelSearch::ByteMatches> ParallelSearch::searchWave(const PieceTable& pieceTable, const LiteralSearch& literal,
+                                                              const QVector<ByteRange>& wave, bool wholeWord, Scan scan,
+                                                              qsizetype limit) {
+    if (wave.size() == 1) {
+        return {findInBytes(pieceTable, literal, wave.first(), wholeWord, scan, limit)};
+    }
+    return QtConcurrent::blockingMapped(wave, [&pieceTable, &literal, wholeWord, scan, limit](const ByteRange& range) {
+        return findInBytes(pieceTable, literal, range, wholeWord, scan, limit);
+    });
+}
+
+ParallelSearch::ByteMatches ParallelSearch::findInBytes(const PieceTable& pieceTable, const LiteralSearch& literal,
+                                                        ByteRange range, bool wholeWord, Scan scan, qsizetype limit) {
+    ByteMatches matches;
+    const qint64 length = literal.utf8Size();
+    const qint64 first = qMax<qint64>(0, range.begin - kWordContext);
+    const qint64 last = qMin(pieceTable.size(), range.end + length - 1 + kWordContext);
+    if (range.begin >= range.end || last - range.begin < length || limit <= 0) return matches;
+
+    const qint64 size = last - first;
+    const char* data = nullptr;
+    QByteArray copy;
+    pieceTable.forEachSpan(first, size, [&data, &copy, size](const char* span, qint64 spanLength) {
+        if (copy.isEmpty() && spanLength == size) {
+            data = span;  // One piece covers the chunk: no copy
+            return false;
+        }
+        copy.append(span, spanLength);
+        return true;
+    });
+    if (!data) data = copy.constData();
+
+    const qint64 begin = range.begin - first;
+    const qint64 end = range.end - first;
+    auto accepted = [&](qint64 index) {
+        return !wholeWord || LiteralSearch::isWholeWord(data, 0, size, index, length);
+    };
+
+    if (scan == Scan::Last) {
+        qint64 index = literal.lastIndexIn(data, size, end - 1);
+        while (index >= begin && !accepted(index)) {
+            index = index > 0 ? literal.lastIndexIn(data, size, index - 1) : -1;
+        }
+        if (index >= begin) {
+            matches.append(qMakePair(first + index, first + index + length));
+        }
+        return matches;
+    }
+
+    qint64 index = literal.indexIn(data, size, begin);
+    while (index >= 0 && index < end) {
+        if (!accepted(index)) {
+            index = literal.indexIn(data, size, index + 1);
+            continue;
+        }
+        matches.append(qMakePair(first + index, first + index + length));
+        if (scan == Scan::First || matches.size() >= limit) break;
+        index = literal.indexIn(data, size, index + length);
+    }
+    return matches;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QPair>
+#include <QPromise>
+#include <QString>
+#include <QVector>
+#include "searchoptions.h"
+
+class KeywordList;
+class LiteralSearch;
+class PieceTable;
+
+// Finds every match in one large buffer using all cores. The text is split into
+// line-aligned chunks that are searched on the global QThreadPool, and the per-chunk
+// results are concatenated in chunk order, so the output is sorted like a serial scan.
+// Matches never cross a line (literals exclude newlines, regexes run line by line),
+// which means line-aligned chunks need no overlap and no duplicate filtering.
+class ParallelSearch {
+public:
+    using Matches = QVector<QPair<int, int>>;
+
+    struct Range {
+        qsizetype begin;    // Start of a line
+        qsizetype end;      // Just past a '\n', or the end of the text
+    };
+
+    // Sorted (start, end) positions of every match in `text`, as QTextDocument positions.
+    // Chunks stop early once `promise` is canceled; the result is then incomplete.
+    static Matches findAll(const QString& text, const SearchOptions& options,
+                           const QPromise<Matches>* promise = nullptr);
+    // `keywordList` is the automaton of a keyword list search when the caller already has
+    // it; findAll resolves it once for all chunks
+    static Matches findInRange(const QString& text, Range range, const SearchOptions& options,
+                               const QPromise<Matches>* promise = nullptr, const KeywordList* keywordList = nullptr);
+
+    // findAll for QtConcurrent::run; adds no result when canceled
+    static void run(QPromise<Matches>& promise, const QString& text, const SearchOptions& options);
+
+    // Large files: byte offsets into a piece table's UTF-8 text, literal needles only. The
+    // table is cut into fixed-size chunks, each read with the needle length - 1 bytes of
+    // the next one (and searched in place when a single piece covers it), and the chunks
+    // are searched a wave at a time, one per pool thread.
+    using ByteMatches = QVector<QPair<qint64, qint64>>;
+
+    // Non-overlapping matches in order, at most `limit` of them
+    static ByteMatches findAll(const PieceTable& pieceTable, const LiteralSearch& literal, bool wholeWord,
+                               qsizetype limit);
+    // First match starting at or after `from`, or the last one starting at or before it
+    static qint64 indexIn(const PieceTable& pieceTable, const LiteralSearch& literal, qint64 from, bool wholeWord);
+    static qint64 lastIndexIn(const PieceTable& pieceTable, const LiteralSearch& literal, qint64 from, bool wholeWord);
+
+private:
+    enum class Scan { All, First, Last };
+
+    struct ByteRange {
+        qint64 begin;       // Matches starting in [begin, end) belong to the chunk
+        qint64 end;
+    };
+
+    static QVector<Range> splitLines(const QString& text);
+    static QList<ByteMatches> searchWave(const PieceTable& pieceTable, const LiteralSearch& literal,
+                                         const QVector<ByteRange>& wave, bool wholeWord, Scan scan, qsizetype limit);
+    static ByteMatches findInBytes(const PieceTable& pieceTable, const LiteralSearch& literal, ByteRange range,
+                                   bool wholeWord, Scan scan, qsizetype limit);
+};
@@ -0,0 +1,155 @@
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include "patterncache.h"
+#include "keywordlist.h"
+
+PatternCache& PatternCache::instance() {
+    static PatternCache cache;
+    return cache;
+}
+
+QRegularExpression PatternCache::pattern(const SearchOptions& options) {
+    const QString fileStamp = keywordFileStamp(options);
+    QMutexLocker locker(&m_mutex);
+
+    qsizetype index = findEntry(options, fileStamp);
+    if (index >= 0) {
+        m_entries.move(index, 0);  // Most recently used first
+        return m_entries.first().regex;
+    }
+
+    // Compile outside the lock so other threads are not held up by a large pattern
+    locker.unlock();
+    QRegularExpression::PatternOptions patternOptions = options.matchCase ? QRegularExpression::NoPatternOption
+                                                                          : QRegularExpression::CaseInsensitiveOption;
+    if (options.matchWholeWord) {
+        // \b then treats letters of any script as word characters, as LiteralSearch does
+        patternOptions |= QRegularExpression::UseUnicodePropertiesOption;
+    }
+    QRegularExpression regex(buildPattern(options), patternOptions);
+    if (regex.isValid()) {
+        regex.optimize();  // Compile and JIT now rather than on the first match
+    } else {
+        qDebug() << "Invalid search pattern:" << regex.pattern() << regex.errorString();
+    }
+    locker.relock();
+
+    // Another thread may have compiled the same pattern meanwhile; keep a single entry
+    index = findEntry(options, fileStamp);
+    if (index >= 0) {
+        m_entries.move(index, 0);
+        return m_entries.first().regex;
+    }
+
+    m_entries.prepend({options.keyword, options.findMethod, options.matchWholeWord, options.matchCase, fileStamp, regex});
+    if (m_entries.size() > kCapacity) {
+        m_entries.removeLast();
+    }
+    return regex;
+}
+
+QSharedPointer<const KeywordList> PatternCache::keywordList(const SearchOptions& options) {
+    const QString fileStamp = keywordFileStamp(options);
+    QMutexLocker locker(&m_mutex);
+
+    qsizetype index = findKeywordList(options, fileStamp);
+    if (index >= 0) {
+        m_keywordLists.move(index, 0);
+        return m_keywordLists.first().keywordList;
+    }
+
+    locker.unlock();
+    QSharedPointer<const KeywordList> keywordList(new KeywordList(
+        KeywordList::parse(options.keyword), options.matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive));
+    locker.relock();
+
+    // Threads that missed together built the same automaton; all of them share the first one
+    index = findKeywordList(options, fileStamp);
+    if (index >= 0) {
+        m_keywordLists.move(index, 0);
+        return m_keywordLists.first().keywordList;
+    }
+
+    m_keywordLists.prepend({options.keyword, options.matchCase, fileStamp, keywordList});
+    if (m_keywordLists.size() > kKeywordListCapacity) {
+        m_keywordLists.removeLast();
+    }
+    return keywordList;
+}
+
+// Size and modification time of a keyword list file, so an edited file is read again;
+// empty for any other keyword
+QString PatternCache::keywordFileStamp(const SearchOptions& options) {
+    if (options.findMethod != FindMethod::KeywordList || options.keyword.isEmpty()) return QString();
+
+    const QFileInfo info(options.keyword);
+    if (!info.isFile()) return QString();
+    return QStringLiteral("%1:%2").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+// Callers hold m_mutex
+qsizetype PatternCache::findEntry(const SearchOptions& options, const QString& fileStamp) const {
+    for (qsizetype i = 0; i < m_entries.size(); ++i) {
+        const Entry& entry = m_entries.at(i);
+        if (entry.keyword == options.keyword && entry.findMethod == options.findMethod &&
+            entry.matchWholeWord == options.matchWholeWord && entry.matchCase == options.matchCase &&
+            entry.fileStamp == fileStamp) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+qsizetype PatternCache::findKeywordList(const SearchOptions& options, const QString& fileStamp) const {
+    for (qsizetype i = 0; i < m_keywordLists.size(); ++i) {
+        const KeywordListEntry& entry = m_keywordLists.at(i);
+        if (entry.keyword == options.keyword && entry.matchCase == options.matchCase && entry.fileStamp == fileStamp) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void PatternCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_keywordLists.clear();
+}
+
+QString PatternCache::buildPattern(const SearchOptions& options) {
+    QString pattern;
+    if (options.findMethod == FindMethod::RegularExpression) {
+        pattern = options.keyword;
+    } else if (options.findMethod == FindMethod::SpecialCharacters) {
+        // Expand \n, \t, ... first, then match the result literally
+        pattern = QRegularExpression::escape(expandSpecialCharacters(options.keyword));
+    } else if (options.findMethod == FindMethod::KeywordList) {
+        // Longest first, so the alternation prefers the same match KeywordList does
+        QStringList keywords = KeywordList::parse(options.keyword);
+        std::stable_sort(keywords.begin(), keywords.end(),
+                         [](const QString& a, const QString& b) { return a.size() > b.size(); });
+        for (QString& keyword : keywords) {
+            keyword = QRegularExpression::escape(keyword);
+        }
+        pattern = keywords.isEmpty() ? QStringLiteral("(?!)") : "(?:" + keywords.join('|') + ")";
+    } else { // Simple text search
+        pattern = QRegularExpression::escape(options.keyword);
+    }
+
+    if (options.matchWholeWord) {
+        pattern = "\\b" + pattern + "\\b";
+    }
+    return pattern;
+}
+
+QString PatternCache::expandSpecialCharacters(const QString& input) {
+    QString result = input;
+    result.replace("\\n", "\n");
+    result.replace("\\r", "\r");
+    result.replace("\\t", "\t");
+    result.replace("\\\\", "\\");
+    result.replace("\\0", QString(QChar(0)));
+    return result;
+}
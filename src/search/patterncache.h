@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QMutex>
+#include <QRegularExpression>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "searchoptions.h"
+
+class KeywordList;
+
+// Compiled search patterns, most recently used first. Constructing a QRegularExpression
+// and compiling it dominated repeated Find Next calls, so Search, FileSearchWorker and
+// Helpers share this small cache. Thread safe: copies of a cached QRegularExpression
+// share the compiled (JIT) pattern.
+class PatternCache {
+public:
+    static PatternCache& instance();
+
+    // Keyword as interpreted by options.findMethod, with whole-word boundaries and case
+    // sensitivity applied. Check isValid() on the result for user-supplied regexes.
+    QRegularExpression pattern(const SearchOptions& options);
+
+    // Automaton for a FindMethod::KeywordList search; a keyword file is read again only
+    // once its size or modification time changes
+    QSharedPointer<const KeywordList> keywordList(const SearchOptions& options);
+    void clear();
+
+    static QString buildPattern(const SearchOptions& options);
+    static QString expandSpecialCharacters(const QString& input);
+
+private:
+    PatternCache() = default;
+
+    struct Entry {
+        QString keyword;
+        FindMethod findMethod;
+        bool matchWholeWord;
+        bool matchCase;
+        QString fileStamp;      // See keywordFileStamp()
+        QRegularExpression regex;
+    };
+
+    struct KeywordListEntry {
+        QString keyword;
+        bool matchCase;
+        QString fileStamp;
+        QSharedPointer<const KeywordList> keywordList;
+    };
+
+    static QString keywordFileStamp(const SearchOptions& options);
+    qsizetype findEntry(const SearchOptions& options, const QString& fileStamp) const;
+    qsizetype findKeywordList(const SearchOptions& options, const QString& fileStamp) const;
+
+    static constexpr int kCapacity = 16;
+    static constexpr int kKeywordListCapacity = 4;
+
+    QMutex m_mutex;
+    QVector<Entry> m_entries;
+    QVector<KeywordListEntry> m_keywordLists;
+};
@@ -0,0 +1,58 @@
+#include "resultqueue.h"
+
+ResultQueue::ResultQueue(int capacity)
+    : m_capacity(capacity), m_head(new Node), m_space(capacity) {
+    m_tail = m_head.load();
+}
+
+ResultQueue::~ResultQueue() {
+    drain();
+    delete m_tail;
+}
+
+bool ResultQueue::push(FileSearchResults result) {
+    const int needed = cost(result);
+    m_space.acquire(needed);
+    if (m_closed.load(std::memory_order_acquire)) {
+        m_space.release(needed);  // Passed on to the next waiting worker
+        return false;
+    }
+
+    Node* node = new Node;
+    node->result = std::move(result);
+    node->cost = needed;
+    Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+    return true;
+}
+
+QVector<FileSearchResults> ResultQueue::drain() {
+    QVector<FileSearchResults> results;
+    int released = 0;
+
+    // A producer between its exchange and its store is picked up by the next drain
+    Node* next = m_tail->next.load(std::memory_order_acquire);
+    while (next) {
+        results.append(std::move(next->result));
+        released += next->cost;
+        delete m_tail;
+        m_tail = next;
+        next = m_tail->next.load(std::memory_order_acquire);
+    }
+
+    if (released > 0 && !m_closed.load(std::memory_order_acquire)) {
+        m_space.release(released);
+    }
+    return results;
+}
+
+void ResultQueue::close() {
+    if (!m_closed.exchange(true, std::memory_order_acq_rel)) {
+        m_space.release(m_capacity);  // Every waiter asks for at most the capacity
+    }
+}
+
+// Match lines, bounded so a single huge file cannot wait forever
+int ResultQueue::cost(const FileSearchResults& result) const {
+    return qBound(1, int(result.lines.size()), m_capacity);
+}
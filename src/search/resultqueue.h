@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QVector>
+#include <atomic>
+#include "searchoptions.h"
+
+// Hands file results from search workers to the GUI thread in bulk. Workers push without
+// taking a lock (a linked list whose head they swap atomically) and the GUI drains
+// everything on a timer, so tens of thousands of small files no longer mean as many
+// queued signals. The number of buffered match lines is capped: a worker that would
+// exceed it waits until the GUI has drained.
+class ResultQueue {
+public:
+    explicit ResultQueue(int capacity);
+    ~ResultQueue();
+
+    ResultQueue(const ResultQueue&) = delete;
+    ResultQueue& operator=(const ResultQueue&) = delete;
+
+    // Any thread; false once the queue is closed
+    bool push(FileSearchResults result);
+
+    // Single consumer; everything pushed so far, oldest first
+    QVector<FileSearchResults> drain();
+
+    // Releases waiting workers and refuses further results
+    void close();
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        FileSearchResults result;
+        int cost = 0;
+    };
+
+    int cost(const FileSearchResults& result) const;
+
+    const int m_capacity;
+    std::atomic<Node*> m_head;  // Last pushed, swapped by producers
+    Node* m_tail;               // Already consumed; its successor is the oldest result
+    QSemaphore m_space;
+    std::atomic<bool> m_closed{false};
+};
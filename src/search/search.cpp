@@ -1,7 +1,18 @@
 #include <QDebug>
 #include <QRegularExpression>
+#include <QTextBlock>
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#include <QMessageBox>
+#include <QProgressDialog>
 #include "search.h"
 #include "../search/searchoptions.h"
+#include "patterncache.h"
+#include "literalsearch.h"
+#include "parallelsearch.h"
+#include "../replace/replaceengine.h"
+#include "../largefileeditor.h"
+#include "../piecetable.h"
 
 Search::Search(CodeEditor* editor, SearchOptions* options)
     : m_editor(editor)
@@ -31,61 +42,29 @@ void Search::selectAll() {
         return; // Ensure the editor, options, and document are valid
     }
 
-    // Check the role (must be SelectAll)
-    if (m_searchOptions->role != Role::SelectAll) {
-        return; // Exit if the role is not SelectAll
-    }
-
-    QTextDocument* document = m_editor->document();
-    QTextCursor cursor(document);
-
-    // Prepare the keyword or regex pattern
-    QString pattern;
-    if (m_searchOptions->findMethod == FindMethod::RegularExpression) {
-        pattern = m_searchOptions->keyword;
-    } else if (m_searchOptions->findMethod == FindMethod::SpecialCharacters) {
-        // Handle special characters like \n, \t, \r
-        pattern = QRegularExpression::escape(m_searchOptions->keyword)
-                      .replace("\\n", "\n").replace("\\t", "\t")
-                      .replace("\\r", "\r").replace("\\0", "\0").replace("\\\\", "\\");
-    } else { // Simple text search
-        pattern = QRegularExpression::escape(m_searchOptions->keyword);
-    }
-
-    // Add whole word boundaries if needed
-    if (m_searchOptions->matchWholeWord) {
-        pattern = "\\b" + pattern + "\\b";
-    }
-
-    // Compile the regular expression
-    QRegularExpression regex(pattern);
-    if (!regex.isValid()) {
-        return; // Invalid regex, do nothing
+    if (m_largeEditor && m_largeEditor->pieceTable()) {
+        selectAllLargeEditor();
+        return;
     }
 
-    // Case sensitivity
-    QRegularExpression::PatternOptions regexOptions = QRegularExpression::NoPatternOption;
-    if (!m_searchOptions->matchCase) {
-        regexOptions |= QRegularExpression::CaseInsensitiveOption;
-    }
-    regex.setPatternOptions(regexOptions);
-
-    // Highlighting format
-    QTextCharFormat highlightFormat;
-    highlightFormat.setBackground(Qt::yellow);
-    highlightFormat.setForeground(Qt::black);
-
-    // Start iterating over the document to find and highlight matches
-    cursor.movePosition(QTextCursor::Start); // Start from the beginning of the document
-    while (!cursor.isNull() && !cursor.atEnd()) {
-        cursor = document->find(regex, cursor); // Find the next match
-        if (!cursor.isNull()) {
-            cursor.mergeCharFormat(highlightFormat); // Apply highlight to matched text
+    // Matches are collected from a snapshot off the GUI thread, in parallel chunks for
+    // large texts; the editor then paints the visible ones instead of formatting every
+    // match in the document
+    CodeEditor* editor = m_editor;
+    const QString text = editor->document()->toPlainText();
+    const int revision = editor->document()->revision();
+    const SearchOptions options = *m_searchOptions;
+
+    QtConcurrent::run([text, options]() {
+        return ParallelSearch::findAll(text, options);
+    }).then(editor, [editor, revision](const QVector<QPair<int, int>>& matches) {
+        if (editor->document()->revision() != revision) {
+            return; // Edited meanwhile, the offsets no longer apply
         }
-    }
+        editor->setSearchMatches(matches);
+    });
 }
 
-// FIXME: replaceAll causes segmentation fault.
 void Search::replaceAll() {
     m_searchOptions->role = Role::ReplaceAll;
     setSearchOptions(*m_searchOptions);
@@ -95,71 +74,59 @@ void Search::replaceAll() {
         return;
     }
 
-    QTextDocument* document = m_editor->document();
-    if (!document) {
-        qDebug() << "Document is null.";
-        return;
+    if (m_largeEditor && m_largeEditor->pieceTable()) {
+        return; // The dialog tells the user; the piece table is not edited by Replace
     }
 
-    QSignalBlocker blocker(m_editor); // Block signals during the operation
-
-    // Extract plain text from the document
-    QString documentText = document->toPlainText();
-    if (documentText.isEmpty()) {
+    CodeEditor* editor = m_editor;
+    QTextDocument* document = editor->document();
+    const QString text = document->toPlainText();
+    if (text.isEmpty()) {
         qDebug() << "Document is empty.";
         return;
     }
 
-    // Prepare the regex pattern
-    QString pattern;
-    if (m_searchOptions->findMethod == FindMethod::RegularExpression) {
-        pattern = m_searchOptions->keyword;
-    } else if (m_searchOptions->findMethod == FindMethod::SpecialCharacters) {
-        pattern = QRegularExpression::escape(m_searchOptions->keyword)
-        .replace("\\n", "\n")
-            .replace("\\t", "\t")
-            .replace("\\r", "\r")
-            .replace("\\0", "\0")
-            .replace("\\\\", "\\");
-    } else {
-        pattern = QRegularExpression::escape(m_searchOptions->keyword);
-    }
-
-    if (m_searchOptions->matchWholeWord) {
-        pattern = "\\b" + pattern + "\\b";
-    }
-
-    QRegularExpression regex(pattern);
-    if (!regex.isValid()) {
-        qDebug() << "Invalid regex pattern.";
-        return;
-    }
-
-    QRegularExpression::PatternOptions regexOptions = QRegularExpression::NoPatternOption;
-    if (!m_searchOptions->matchCase) {
-        regexOptions |= QRegularExpression::CaseInsensitiveOption;
-    }
-    regex.setPatternOptions(regexOptions);
-
-    QString replacement = m_searchOptions->replaceText;
-
-    // Replace matches in memory
-    QString updatedText = documentText;
-    QRegularExpressionMatchIterator it = regex.globalMatch(documentText);
-    int replaceCount = 0;
+    // The replacement is built on a worker thread from a snapshot of the text
+    const int revision = document->revision();
+    auto* watcher = new QFutureWatcher<ReplaceEngine::Result>(editor);
+
+    // Only shown if the replacement takes longer than half a second
+    auto* progress = new QProgressDialog(QObject::tr("Replacing..."), QObject::tr("Cancel"), 0, 0, editor);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(500);
+    QObject::connect(watcher, &QFutureWatcherBase::progressRangeChanged, progress, &QProgressDialog::setRange);
+    QObject::connect(watcher, &QFutureWatcherBase::progressValueChanged, progress, &QProgressDialog::setValue);
+    QObject::connect(progress, &QProgressDialog::canceled, watcher, &QFutureWatcherBase::cancel);
+
+    QObject::connect(watcher, &QFutureWatcherBase::finished, editor, [editor, watcher, progress, revision]() {
+        progress->deleteLater();
+        watcher->deleteLater();
+
+        if (watcher->isCanceled() || watcher->future().resultCount() == 0) {
+            qDebug() << "Replace All canceled.";
+            return;
+        }
+        if (editor->document()->revision() != revision) {
+            qDebug() << "Document changed during Replace All, result discarded.";
+            return;
+        }
 
-    while (it.hasNext()) {
-        QRegularExpressionMatch match = it.next();
-        if (match.hasMatch()) {
-            updatedText.replace(match.capturedStart(), match.capturedLength(), replacement);
-            ++replaceCount;
+        const ReplaceEngine::Result result = watcher->result();
+        if (result.count > 0) {
+            // One edit block covering first to last match: a single undo step, and the
+            // text outside that range keeps its blocks and formats
+            QTextCursor cursor(editor->document());
+            cursor.beginEditBlock();
+            cursor.setPosition(result.first);
+            cursor.setPosition(result.last, QTextCursor::KeepAnchor);
+            cursor.insertText(result.text);
+            cursor.endEditBlock();
         }
-    }
 
-    // Update the document with the modified text
-    document->setPlainText(updatedText);
+        qDebug() << "Replacement complete. Replaced" << result.count << "occurrences.";
+    });
 
-    qDebug() << "Replacement complete. Replaced" << replaceCount << "occurrences.";
+    watcher->setFuture(QtConcurrent::run(&ReplaceEngine::run, text, *m_searchOptions));
 }
 
 void Search::setEditor(CodeEditor* editor) {
@@ -167,6 +134,10 @@ void Search::setEditor(CodeEditor* editor) {
     m_cursor = m_editor ? QTextCursor(m_editor->document()) : QTextCursor();
 }
 
+void Search::setLargeEditor(LargeFileEditor* largeEditor) {
+    m_largeEditor = largeEditor;
+}
+
 void Search::setSearchOptions(const SearchOptions& options) {
     clearHighlights();
     *m_searchOptions = options;
@@ -192,32 +163,26 @@ bool Search::search() {
         flags |= QTextDocument::FindCaseSensitively; // Case sensitivity
     }
 
-    // Prepare the keyword based on FindMethod
-    QString keyword;
-    if (m_searchOptions->findMethod == FindMethod::SpecialCharacters) {
-        keyword = expandSpecialCharacters(m_searchOptions->keyword);
-    } else if (m_searchOptions->findMethod == FindMethod::RegularExpression) {
-        keyword = m_searchOptions->keyword; // Use directly for regex
-    } else { // Simple text search
-        keyword = QRegularExpression::escape(m_searchOptions->keyword);
+    const bool backward = flags.testFlag(QTextDocument::FindBackward);
+    if (m_largeEditor && m_largeEditor->pieceTable()) {
+        return searchLargeEditor(backward);
     }
 
-    if (m_searchOptions->matchWholeWord) {
-        // Add whole word boundaries
-        keyword = "\\b" + keyword + "\\b";
-    }
+    QTextCursor resultCursor;
+    const QString literal = literalKeyword(*m_searchOptions);
+    if (!literal.isEmpty()) {
+        resultCursor = findLiteral(LiteralSearch(literal, caseSensitivity()), backward);
+    } else {
+        // Reuses the compiled pattern while the keyword and options stay the same (F3 repeats)
+        QRegularExpression regex = PatternCache::instance().pattern(*m_searchOptions);
+        if (!regex.isValid()) {
+            qDebug() << "Invalid regex in search: " << regex;
+            return false; // Invalid regex, do nothing
+        }
 
-    // Compile regex
-    QRegularExpression regex(keyword);
-    if (!regex.isValid()) {
-        qDebug() << "Invalid regex in search: " << regex;
-        return false; // Invalid regex, do nothing
+        // Perform the search
+        resultCursor = m_editor->document()->find(regex, m_cursor, flags);
     }
-    regex.setPatternOptions(m_searchOptions->matchCase ? QRegularExpression::NoPatternOption
-                                                       : QRegularExpression::CaseInsensitiveOption);
-
-    // Perform the search
-    QTextCursor resultCursor = m_editor->document()->find(regex, m_cursor, flags);
 
     if (!resultCursor.isNull()) {
         // Handle replacement if Role is ReplaceNext or ReplacePrevious
@@ -238,38 +203,110 @@ bool Search::search() {
     return false; // No match found
 }
 
-QString Search::expandSpecialCharacters(const QString& input) const {
-    QString result = input;
-    result.replace("\\n", "\n");
-    result.replace("\\r", "\r");
-    result.replace("\\t", "\t");
-    result.replace("\\\\", "\\");
-    result.replace("\\0", "\0");
-    qDebug() << "Expanded search keyword:" << result;
-    return result;
-}
+QString Search::literalKeyword(const SearchOptions& options) {
+    QString keyword;
+    if (options.findMethod == FindMethod::SimpleText) {
+        keyword = options.keyword;
+    } else if (options.findMethod == FindMethod::SpecialCharacters) {
+        keyword = PatternCache::expandSpecialCharacters(options.keyword);
+    }
 
-void Search::clearHighlights() {
-    if (!m_editor || !m_editor->document()) {
-        return;
+    // Blocks are searched one at a time, so line breaks still go through the regex path
+    if (keyword.contains(QLatin1Char('\n')) || keyword.contains(QLatin1Char('\r'))) {
+        return QString();
     }
+    return keyword;
+}
 
+Qt::CaseSensitivity Search::caseSensitivity() const {
+    return m_searchOptions->matchCase ? Qt::CaseSensitive : Qt::CaseInsensitive;
+}
+
+// Same starting points as QTextDocument::find: after the selection going forward, before it going back
+QTextCursor Search::findLiteral(const LiteralSearch& literal, bool backward) const {
     QTextDocument* document = m_editor->document();
-    QTextCursor cursor(document);
+    const int position = backward ? m_cursor.selectionStart() : m_cursor.selectionEnd();
+    QTextBlock block = document->findBlock(position);
+    qsizetype offset = position - block.position();
+
+    while (block.isValid()) {
+        const QString text = block.text();
+        qsizetype index = backward ? literal.lastIndexIn(text, offset - 1) : literal.indexIn(text, offset);
+
+        while (index >= 0 && m_searchOptions->matchWholeWord && !LiteralSearch::isWholeWord(text, index, literal.size())) {
+            index = backward ? literal.lastIndexIn(text, index - 1) : literal.indexIn(text, index + 1);
+        }
 
-    // Select the entire document
-    cursor.select(QTextCursor::Document);
+        if (index >= 0) {
+            QTextCursor match(document);
+            match.setPosition(block.position() + index);
+            match.setPosition(block.position() + index + literal.size(), QTextCursor::KeepAnchor);
+            return match;
+        }
 
-    // Create a default format with no background or text color
-    QTextCharFormat defaultFormat;
-    defaultFormat.clearBackground(); // Removes background color
-    defaultFormat.clearForeground(); // Resets text color to default
+        block = backward ? block.previous() : block.next();
+        offset = backward ? block.length() : 0;
+    }
 
-    // Apply the default format to the entire document
-    cursor.setCharFormat(defaultFormat);
+    return QTextCursor();
 }
 
+// Searches the UTF-8 piece table of a large file in place; only plain text is supported there
+bool Search::searchLargeEditor(bool backward) {
+    if (m_searchOptions->role == Role::ReplaceNext || m_searchOptions->role == Role::ReplacePrevious) {
+        return false; // The dialog tells the user; the piece table is not edited by Replace
+    }
 
+    const QString keyword = literalKeyword(*m_searchOptions);
+    const LiteralSearch literal(keyword, caseSensitivity());
+    if (keyword.isEmpty() || !literal.supportsUtf8()) {
+        showLargeFileLimit();
+        return false;
+    }
+
+    // Chunks on every core; blocking, so the table cannot change under the search
+    const PieceTable& pieceTable = *m_largeEditor->pieceTable();
+    const qint64 found = backward
+        ? ParallelSearch::lastIndexIn(pieceTable, literal, m_largeEditor->selectionStart() - 1, m_searchOptions->matchWholeWord)
+        : ParallelSearch::indexIn(pieceTable, literal, m_largeEditor->selectionEnd(), m_searchOptions->matchWholeWord);
+    if (found < 0) {
+        return false;
+    }
 
+    m_largeEditor->setSelection(found, found + literal.utf8Size());
+    return true;
+}
 
+// Matches are kept as byte ranges and painted by the editor; past kMaxLargeMatches the
+// rest is not highlighted, which bounds the memory a very common needle can take
+void Search::selectAllLargeEditor() {
+    const QString keyword = literalKeyword(*m_searchOptions);
+    const LiteralSearch literal(keyword, caseSensitivity());
+    if (keyword.isEmpty() || !literal.supportsUtf8()) {
+        showLargeFileLimit();
+        return;
+    }
 
+    const ParallelSearch::ByteMatches matches = ParallelSearch::findAll(
+        *m_largeEditor->pieceTable(), literal, m_searchOptions->matchWholeWord, kMaxLargeMatches);
+    if (matches.size() == kMaxLargeMatches) {
+        qInfo() << "Select All highlights the first" << kMaxLargeMatches << "matches only.";
+    }
+    m_largeEditor->setSearchMatches(matches);
+}
+
+// Said out loud, since a search the piece table cannot run would otherwise look like no match
+void Search::showLargeFileLimit() const {
+    QMessageBox::information(m_largeEditor, "Information",
+                             "Large files support plain-text search only. Without Match Case the keyword "
+                             "must be ASCII and free of 'k' and 's', which other characters fold to.");
+}
+
+void Search::clearHighlights() {
+    if (m_editor) {
+        m_editor->clearSearchMatches(); // Only ExtraSelections were added, the text formats are untouched
+    }
+    if (m_largeEditor) {
+        m_largeEditor->clearSearchMatches();
+    }
+}
@@ -4,6 +4,9 @@
 #include "searchoptions.h"
 #include "../codeeditor.h"
 
+class LargeFileEditor;
+class LiteralSearch;
+
 class Search {
 public:
     explicit Search(CodeEditor* editor = nullptr, SearchOptions* options = nullptr);
@@ -11,20 +14,29 @@ public:
 
     void setSearchOptions(const SearchOptions& options);
     void setEditor(CodeEditor* editor);  // Add setEditor declaration
+    void setLargeEditor(LargeFileEditor* largeEditor);
 
     virtual bool findNext();
     virtual bool findPrevious();
     virtual void selectAll();
     virtual void replaceAll();
 
+    // Keyword to match literally, or an empty string when the regex engine is needed
+    static QString literalKeyword(const SearchOptions& options);
+
 protected:
     bool search();
     void clearHighlights();
+    Qt::CaseSensitivity caseSensitivity() const;
+    QTextCursor findLiteral(const LiteralSearch& literal, bool backward) const;
+    bool searchLargeEditor(bool backward);
+    void selectAllLargeEditor();
+    void showLargeFileLimit() const;
+
+    static constexpr qsizetype kMaxLargeMatches = 1000000;
 
     CodeEditor* m_editor;
+    LargeFileEditor* m_largeEditor = nullptr;
     QTextCursor m_cursor;
     SearchOptions* m_searchOptions;
-
-private:
-    QString expandSpecialCharacters(const QString& input) const;
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+
+// Shared by a directory search's dialog and its workers. The dialog sets `canceled` and
+// workers poll it between files and between lines, so even a search stuck in a huge file
+// stops at once. Workers add to the counters, which the dialog reads for its
+// throughput readout; nothing here needs a lock.
+struct SearchControl {
+    std::atomic<bool> canceled{false};
+    std::atomic<int> filesSearched{0};     // Text or not, so it adds up to what the walk found
+    std::atomic<qint64> bytesSearched{0};
+    std::atomic<qint64> matches{0};
+
+    bool isCanceled() const {
+        return canceled.load(std::memory_order_relaxed);
+    }
+};
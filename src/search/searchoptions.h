@@ -3,6 +3,7 @@
 #include <QString>
 #include <QVector>
 #include <QPair>
+#include <QMap>
 
 // Enum to represent the role
 enum class Role {
@@ -18,7 +19,8 @@ enum class Role {
 enum class FindMethod {
     SimpleText,
     RegularExpression,
-    SpecialCharacters
+    SpecialCharacters,
+    KeywordList         // Any of several keywords, see KeywordList::parse
 };
 
 // Struct to hold search options
@@ -50,10 +52,20 @@ struct SearchProgress {
     int totalFiles = 0;                 // Total files to process
 };
 
+// Matches as numbers only: the text of a line is read back from the file when it is shown,
+// so nothing in it (not even markup) can shift a match
 struct FileSearchResults {
+    struct Line {
+        int lineNumber;                         // 0-based
+        int firstRange;                         // Into `ranges`
+        int rangeCount;                         // Matches on the line
+    };
+
     QString filePath;                           // Path of the file
     int matchCount;                             // Number of matches in the file
-    QVector<QString> matchingLines;             // Lines containing matches, with keywords highlighted
-    QVector<QPair<int, QString>> matches;       // Pairs of (line number, line text) for each match
+    QVector<Line> lines;                        // Lines containing matches, in file order
+    QVector<QPair<int, int>> ranges;            // (start, length) of each match in its decoded line
+    QVector<QString> lineTexts;                 // Text per entry of `lines`, for results not read from disk (tabs)
+    QMap<QString, int> keywordCounts;           // Matches per keyword, for keyword list searches
 };
 
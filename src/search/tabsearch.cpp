@@ -0,0 +1,122 @@
+#include <QtConcurrent>
+#include "tabsearch.h"
+#include "parallelsearch.h"
+#include "../codeeditor.h"
+#include "../document.h"
+#include "../piecetable.h"
+
+namespace {
+
+constexpr qint64 kBlockBytes = 4 * 1024 * 1024; // Piece tables are decoded a few lines at a time
+
+}
+
+TabSearch::TabSearch(QObject* parent)
+    : QObject(parent) {
+}
+
+TabSearch::~TabSearch() {
+    cancel();
+}
+
+TabSearch::Snapshot TabSearch::snapshot(const Document* document, const QString& name) {
+    Snapshot snapshot;
+    snapshot.name = name;
+    if (document->isLoading()) {
+        return snapshot;  // The worker thread is still filling it; callers skip such tabs
+    }
+    if (document->isLargeFile()) {
+        snapshot.pieceTable = std::make_shared<const PieceTable>(*document->pieceTable());
+    } else if (document->editor()) {
+        snapshot.text = document->editor()->document()->toPlainText();
+    }
+    return snapshot;
+}
+
+void TabSearch::start(const QVector<Snapshot>& snapshots, const SearchOptions& options) {
+    cancel();
+
+    const int generation = m_generation;
+    for (const Snapshot& snapshot : snapshots) {
+        QFuture<FileSearchResults> future = QtConcurrent::run(&TabSearch::search, snapshot, options);
+        future.then(this, [this, generation](QFuture<FileSearchResults> finished) {
+            if (generation != m_generation || finished.resultCount() == 0) {
+                return; // Canceled, or superseded by a newer search
+            }
+            const FileSearchResults result = finished.result();
+            if (result.matchCount > 0) {
+                emit tabSearched(result);
+            }
+        });
+        m_futures.append(future);
+    }
+}
+
+void TabSearch::cancel() {
+    ++m_generation;
+    for (QFuture<FileSearchResults>& future : m_futures) {
+        future.cancel();
+    }
+    m_futures.clear();
+}
+
+void TabSearch::search(QPromise<FileSearchResults>& promise, const Snapshot& snapshot, const SearchOptions& options) {
+    FileSearchResults result;
+    result.filePath = snapshot.name;
+    result.matchCount = 0;
+
+    if (!snapshot.pieceTable) {
+        collect(snapshot.text, 0, options, result);
+    } else {
+        // Whole lines per block, so matches never straddle two blocks
+        const PieceTable& pieceTable = *snapshot.pieceTable;
+        const qint64 lineCount = pieceTable.lineCount();
+        qint64 line = 0;
+        while (line < lineCount && !promise.isCanceled()) {
+            const qint64 start = pieceTable.lineStart(line);
+            qint64 endLine = pieceTable.lineAt(qMin(start + kBlockBytes, pieceTable.size()));
+            if (endLine <= line) endLine = line + 1;
+            const qint64 end = pieceTable.lineStart(endLine);
+
+            collect(QString::fromUtf8(pieceTable.read(start, end - start)), int(line), options, result);
+            line = endLine;
+        }
+    }
+
+    if (promise.isCanceled()) {
+        return;
+    }
+    promise.addResult(result);
+}
+
+// Appends the matches in `text` to `result` as FileSearchWorker does: each matching line
+// once, with its match ranges; the line text too, since a tab may differ from its file
+void TabSearch::collect(const QString& text, int firstLine, const SearchOptions& options, FileSearchResults& result) {
+    const ParallelSearch::Matches matches = ParallelSearch::findAll(text, options);
+
+    int lineNumber = firstLine;
+    qsizetype lineStart = 0;
+    qsizetype i = 0;
+    while (i < matches.size()) {
+        // Advance to the line holding the next match
+        qsizetype lineEnd = text.indexOf(QLatin1Char('\n'), lineStart);
+        if (lineEnd < 0) lineEnd = text.size();
+        if (matches.at(i).first > lineEnd) {
+            lineStart = lineEnd + 1;
+            ++lineNumber;
+            continue;
+        }
+
+        const qsizetype first = i;
+        const int firstRange = int(result.ranges.size());
+        for (; i < matches.size() && matches.at(i).first <= lineEnd; ++i) {
+            const QPair<int, int>& match = matches.at(i);
+            const qsizetype end = qMin<qsizetype>(match.second, lineEnd);  // Clipped to the line; a row shows one
+            result.ranges.append(qMakePair(int(match.first - lineStart), int(end - match.first)));
+        }
+
+        result.lines.append({lineNumber, firstRange, int(i - first)});
+        result.lineTexts.append(text.mid(lineStart, lineEnd - lineStart));
+        result.matchCount += int(i - first);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QPromise>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "searchoptions.h"
+
+class Document;
+class PieceTable;
+
+// Find in all open tabs. Each tab is snapshotted on the GUI thread (the plain text of a
+// QTextDocument, or a copy of a large file's piece table, which shares the mapped file and
+// the added-text buffer until either side edits), then every snapshot is searched
+// concurrently on the global QThreadPool. Results arrive per tab through tabSearched(),
+// in completion order, while the editors stay responsive.
+class TabSearch : public QObject {
+    Q_OBJECT
+
+public:
+    struct Snapshot {
+        QString name;                                   // Reported as FileSearchResults::filePath
+        QString text;
+        std::shared_ptr<const PieceTable> pieceTable;   // Set instead of `text` for large files
+    };
+
+    explicit TabSearch(QObject* parent = nullptr);
+    ~TabSearch();
+
+    // Empty for a document still loading, which must not be read from the GUI thread yet
+    static Snapshot snapshot(const Document* document, const QString& name);
+
+    // Cancels a search still running and starts a new one
+    void start(const QVector<Snapshot>& snapshots, const SearchOptions& options);
+    void cancel();
+
+signals:
+    void tabSearched(const FileSearchResults& result);  // Only for tabs with matches
+
+private:
+    static void search(QPromise<FileSearchResults>& promise, const Snapshot& snapshot, const SearchOptions& options);
+    static void collect(const QString& text, int firstLine, const SearchOptions& options, FileSearchResults& result);
+
+    QVector<QFuture<FileSearchResults>> m_futures;
+    int m_generation = 0;
+};
@@ -0,0 +1,94 @@
+#include <QFile>
+#include <QFileInfo>
+#include "textclassifier.h"
+
+#ifndef Q_OS_WIN
+#include <sys/stat.h>
+#endif
+
+TextClassifier& TextClassifier::instance() {
+    static TextClassifier classifier;
+    return classifier;
+}
+
+bool TextClassifier::isText(const QString& filePath) {
+    FileId id;
+    if (!fileId(filePath, id)) {
+        return false;  // Missing, or not a regular file
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_cache.constFind(id);
+        if (it != m_cache.constEnd()) {
+            return it.value();
+        }
+    }
+
+    // Read outside the lock, other threads keep classifying meanwhile
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const bool text = isText(QByteArrayView(file.read(kSampleSize)));
+
+    QMutexLocker locker(&m_mutex);
+    if (m_cache.size() >= kCapacity) {
+        m_cache.clear();
+    }
+    m_cache.insert(id, text);
+    return text;
+}
+
+void TextClassifier::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+bool TextClassifier::isText(QByteArrayView head) {
+    // A BOM settles it, and UTF-16/32 text is full of NUL bytes
+    if (head.startsWith("\xEF\xBB\xBF") || head.startsWith("\xFF\xFE") || head.startsWith("\xFE\xFF")
+        || head.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4))) {
+        return true;
+    }
+
+    qsizetype controlBytes = 0;
+    for (const char c : head) {
+        const uchar byte = uchar(c);
+        if (byte == 0) {
+            return false;
+        }
+        // Tab, line feed, vertical tab, form feed, carriage return and escape (ANSI
+        // colored logs) are common in text; bytes from 0x80 up belong to some encoding
+        if ((byte < 0x20 && byte != '\b' && (byte < '\t' || byte > '\r') && byte != 0x1B) || byte == 0x7F) {
+            ++controlBytes;
+        }
+    }
+    return controlBytes * 32 <= head.size();  // At most ~3% stray control bytes
+}
+
+bool TextClassifier::fileId(const QString& filePath, FileId& id) {
+#ifndef Q_OS_WIN
+    struct stat status;
+    if (::stat(QFile::encodeName(filePath).constData(), &status) != 0 || !S_ISREG(status.st_mode)) {
+        return false;
+    }
+    id.device = quint64(status.st_dev);
+    id.inode = quint64(status.st_ino);
+#if defined(Q_OS_DARWIN)
+    id.modified = qint64(status.st_mtimespec.tv_sec) * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+    id.modified = qint64(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+    id.size = qint64(status.st_size);
+#else
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        return false;
+    }
+    id.path = info.absoluteFilePath();
+    id.modified = info.lastModified().toMSecsSinceEpoch();
+    id.size = info.size();
+#endif
+    return true;
+}
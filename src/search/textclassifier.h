@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Decides whether a file is text worth searching or opening. QMimeDatabase combined
+// globbing with magic sniffing, which was slow per file and rejected text with unknown
+// or non "text/" extensions (.json, .svg, no extension at all). This only reads the
+// first 8 KB: a Unicode BOM means text, a NUL byte or too many control bytes mean
+// binary. Results are cached per file identity (device, inode, mtime and size), so a
+// repeated search over the same tree does not open the files again. Thread safe.
+class TextClassifier {
+public:
+    static TextClassifier& instance();
+
+    bool isText(const QString& filePath);
+    void clear();
+
+    static bool isText(QByteArrayView head);   // Heuristic on the first bytes of a file
+
+private:
+    TextClassifier() = default;
+
+    struct FileId {
+        QString path;           // Only where there are no inode numbers
+        quint64 device = 0;
+        quint64 inode = 0;
+        qint64 modified = 0;    // Nanoseconds where available
+        qint64 size = 0;
+
+        bool operator==(const FileId& other) const = default;
+    };
+    friend size_t qHash(const FileId& id, size_t seed) {
+        return qHashMulti(seed, id.path, id.device, id.inode, id.modified, id.size);
+    }
+
+    static bool fileId(const QString& filePath, FileId& id);
+
+    static constexpr qsizetype kSampleSize = 8 * 1024;
+    static constexpr qsizetype kCapacity = 1 << 16;   // Entries kept before the cache starts over
+
+    QMutex m_mutex;
+    QHash<FileId, bool> m_cache;
+};
@@ -0,0 +1,499 @@
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <algorithm>
+#include <vector>
+#include "trigramindex.h"
+#include "keywordlist.h"
+#include "patterncache.h"
+#include "textclassifier.h"
+
+namespace {
+
+constexpr quint32 kMagic = 0x4e505449;               // "NPTI"
+constexpr quint32 kVersion = 1;
+constexpr qint64 kMaxIndexedSize = 64 * 1024 * 1024;  // Larger files are always searched
+constexpr qint64 kBlockSize = 1024 * 1024;
+
+inline uchar foldCase(uchar byte) {
+    return byte >= 'A' && byte <= 'Z' ? byte + ('a' - 'A') : byte;
+}
+
+void appendVarint(QByteArray& out, quint32 value) {
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// Index just past the character class starting at `i`
+qsizetype skipClass(const QString& pattern, qsizetype i) {
+    const qsizetype n = pattern.size();
+    qsizetype j = i + 1;
+    if (j < n && pattern.at(j) == QLatin1Char('^')) ++j;
+    if (j < n && pattern.at(j) == QLatin1Char(']')) ++j;  // A leading ']' is literal
+    while (j < n) {
+        const QChar c = pattern.at(j);
+        if (c == QLatin1Char('\\')) {
+            j += 2;
+        } else if (c == QLatin1Char('[') && j + 1 < n && pattern.at(j + 1) == QLatin1Char(':')) {
+            const qsizetype end = pattern.indexOf(QLatin1String(":]"), j + 2);
+            j = end < 0 ? n : end + 2;
+        } else if (c == QLatin1Char(']')) {
+            return j + 1;
+        } else {
+            ++j;
+        }
+    }
+    return n;
+}
+
+// Index just past the group starting at `i`
+qsizetype skipGroup(const QString& pattern, qsizetype i) {
+    const qsizetype n = pattern.size();
+    int depth = 0;
+    qsizetype j = i;
+    while (j < n) {
+        const QChar c = pattern.at(j);
+        if (c == QLatin1Char('\\')) {
+            j += 2;
+            continue;
+        }
+        if (c == QLatin1Char('[')) {
+            j = skipClass(pattern, j);
+            continue;
+        }
+        if (c == QLatin1Char('(')) {
+            ++depth;
+        } else if (c == QLatin1Char(')') && --depth == 0) {
+            return j + 1;
+        }
+        ++j;
+    }
+    return n;
+}
+
+}
+
+TrigramIndex::TrigramIndex(const QString& root)
+    : m_root(QFileInfo(root).canonicalFilePath()) {
+}
+
+QString TrigramIndex::root() const {
+    return m_root;
+}
+
+bool TrigramIndex::update(const QPromise<void>* promise) {
+    if (m_root.isEmpty()) {
+        return true;  // Nothing there to index
+    }
+    if (!load()) {
+        m_files.clear();
+    }
+
+    QHash<QString, qsizetype> previous;
+    previous.reserve(m_files.size());
+    for (qsizetype i = 0; i < m_files.size(); ++i) {
+        previous.insert(m_files.at(i).path, i);
+    }
+
+    // Only size and mtime are checked here; unchanged files keep their trigrams
+    const qsizetype prefixLength = m_root.endsWith(QLatin1Char('/')) ? m_root.size() : m_root.size() + 1;
+    QVector<File> files;
+    QVector<qsizetype> stale;
+    files.reserve(m_files.size());
+
+    QDirIterator it(m_root, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    int listed = 0;
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if ((++listed & 0xFF) == 0 && promise && promise->isCanceled()) {
+            return false;
+        }
+
+        const QFileInfo info = it.fileInfo();
+        File file;
+        file.path = path.mid(prefixLength);
+        file.size = info.size();
+        file.modified = info.lastModified().toMSecsSinceEpoch();
+
+        const auto old = previous.constFind(file.path);
+        if (old != previous.constEnd() && m_files.at(*old).size == file.size && m_files.at(*old).modified == file.modified) {
+            files.append(std::move(m_files[*old]));
+        } else {
+            stale.append(files.size());
+            files.append(std::move(file));
+        }
+    }
+    const bool changed = !stale.isEmpty() || files.size() - stale.size() != m_files.size();
+
+    File* data = files.data();
+    const QString prefix = m_root.endsWith(QLatin1Char('/')) ? m_root : m_root + QLatin1Char('/');
+    QtConcurrent::blockingMap(stale, [data, &prefix, promise](qsizetype& index) {
+        if (!promise || !promise->isCanceled()) {
+            indexFile(prefix + data[index].path, data[index]);
+        }
+    });
+    if (promise && promise->isCanceled()) {
+        return false;
+    }
+
+    m_files = std::move(files);
+    qDebug() << "Trigram index of" << m_root << ":" << m_files.size() << "files," << stale.size() << "re-indexed";
+    if (changed && !save()) {
+        qWarning() << "Could not save the trigram index to" << indexPath();
+    }
+    return true;
+}
+
+QStringList TrigramIndex::candidates(const SearchOptions& options, const QRegularExpression& fileNamePattern,
+                                     qint64* totalBytes) const {
+    const QVector<TrigramSet> alternatives = requiredTrigrams(options);
+    const bool filterNames = !fileNamePattern.pattern().isEmpty();
+    const QString prefix = m_root.endsWith(QLatin1Char('/')) ? m_root : m_root + QLatin1Char('/');
+
+    QStringList result;
+    qint64 bytes = 0;
+    for (const File& file : m_files) {
+        if (!file.text) continue;
+        if (!options.includeSubdirectories && file.path.contains(QLatin1Char('/'))) continue;
+        if (filterNames && !fileNamePattern.match(file.path.mid(file.path.lastIndexOf(QLatin1Char('/')) + 1)).hasMatch()) {
+            continue;
+        }
+
+        if (file.indexed && !alternatives.isEmpty()) {
+            const bool possible = std::any_of(alternatives.cbegin(), alternatives.cend(), [&file](const TrigramSet& required) {
+                return containsAll(file.trigrams, required);
+            });
+            if (!possible) continue;
+        }
+        result.append(prefix + file.path);
+        bytes += file.size;
+    }
+    if (totalBytes) {
+        *totalBytes = bytes;
+    }
+    return result;
+}
+
+bool TrigramIndex::canNarrow(const SearchOptions& options) {
+    return !requiredTrigrams(options).isEmpty();
+}
+
+QVector<TrigramIndex::TrigramSet> TrigramIndex::requiredTrigrams(const SearchOptions& options) {
+    const bool fold = !options.matchCase;
+
+    // Every keyword of a list is an alternative of its own
+    if (options.findMethod == FindMethod::KeywordList) {
+        QVector<TrigramSet> alternatives;
+        for (const QString& keyword : KeywordList::parse(options.keyword)) {
+            const TrigramSet required = literalTrigrams(keyword, fold);
+            if (required.isEmpty()) {
+                return {};  // A short keyword could be anywhere
+            }
+            alternatives.append(required);
+        }
+        return alternatives;
+    }
+
+    QStringList literals;
+    if (options.findMethod == FindMethod::RegularExpression) {
+        if (!regexLiterals(options.keyword, literals)) {
+            return {};
+        }
+    } else if (options.findMethod == FindMethod::SpecialCharacters) {
+        literals.append(PatternCache::expandSpecialCharacters(options.keyword));
+    } else {
+        literals.append(options.keyword);
+    }
+
+    TrigramSet required;
+    for (const QString& literal : std::as_const(literals)) {
+        required.append(literalTrigrams(literal, fold));
+    }
+    if (required.isEmpty()) {
+        return {};
+    }
+    std::sort(required.begin(), required.end());
+    required.erase(std::unique(required.begin(), required.end()), required.end());
+    return {required};
+}
+
+// Trigrams of the UTF-8 bytes, as indexFile() stores them. Lines are searched one at a
+// time, so no trigram spans a line break. Case folding only covers ASCII, so trigrams
+// with other bytes are left out of case-insensitive queries.
+TrigramIndex::TrigramSet TrigramIndex::literalTrigrams(const QString& literal, bool fold) {
+    const QByteArray utf8 = literal.toUtf8();
+    TrigramSet trigrams;
+    for (qsizetype i = 0; i + 2 < utf8.size(); ++i) {
+        const uchar a = uchar(utf8.at(i)), b = uchar(utf8.at(i + 1)), c = uchar(utf8.at(i + 2));
+        if (a == '\n' || a == '\r' || b == '\n' || b == '\r' || c == '\n' || c == '\r') continue;
+        if (fold && (a >= 0x80 || b >= 0x80 || c >= 0x80)) continue;
+        trigrams.append((quint32(foldCase(a)) << 16) | (quint32(foldCase(b)) << 8) | foldCase(c));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+// Literal runs every match of `pattern` must contain. Groups, classes and anything
+// optional end a run; false when the pattern has a top-level alternation or inline
+// options, which the runs could not account for.
+bool TrigramIndex::regexLiterals(const QString& pattern, QStringList& literals) {
+    static const QRegularExpression inlineOptions(QStringLiteral("\\(\\?[-\\^a-zA-Z]|\\(\\*"));
+    if (pattern.contains(inlineOptions)) {
+        return false;
+    }
+
+    QString run;
+    bool lastIsLiteral = false;  // The last atom is the last character of `run`
+    const auto flush = [&]() {
+        if (!run.isEmpty()) literals.append(run);
+        run.clear();
+        lastIsLiteral = false;
+    };
+    const auto lastCharacterLength = [&]() {
+        return run.size() >= 2 && run.back().isLowSurrogate() ? 2 : 1;
+    };
+
+    const qsizetype n = pattern.size();
+    qsizetype i = 0;
+    while (i < n) {
+        const QChar c = pattern.at(i);
+
+        if (c == QLatin1Char('\\')) {
+            if (i + 1 >= n) break;
+            const QChar e = pattern.at(i + 1);
+            i += 2;
+            if (!e.isLetterOrNumber()) {
+                run.append(e);  // Escaped punctuation is literal
+                lastIsLiteral = true;
+                continue;
+            }
+
+            // Class, anchor, back reference or code point
+            flush();
+            if (e == QLatin1Char('Q')) {
+                const qsizetype end = pattern.indexOf(QLatin1String("\\E"), i);
+                run = pattern.mid(i, end < 0 ? -1 : end - i);
+                lastIsLiteral = !run.isEmpty();
+                i = end < 0 ? n : end + 2;
+            } else if (i < n && (pattern.at(i) == QLatin1Char('{') || pattern.at(i) == QLatin1Char('<')
+                                 || pattern.at(i) == QLatin1Char('\''))) {
+                const QChar close = pattern.at(i) == QLatin1Char('{') ? QLatin1Char('}')
+                                  : pattern.at(i) == QLatin1Char('<') ? QLatin1Char('>') : QLatin1Char('\'');
+                const qsizetype end = pattern.indexOf(close, i + 1);
+                i = end < 0 ? n : end + 1;
+            } else if (e == QLatin1Char('x')) {
+                for (int k = 0; k < 2 && i < n && QStringLiteral("0123456789abcdefABCDEF").contains(pattern.at(i)); ++k) ++i;
+            } else if (e == QLatin1Char('c') || e == QLatin1Char('p') || e == QLatin1Char('P')) {
+                ++i;
+            } else if (e.isDigit() || e == QLatin1Char('g')) {
+                while (i < n && (pattern.at(i).isDigit() || pattern.at(i) == QLatin1Char('-'))) ++i;
+            }
+            continue;
+        }
+
+        if (c == QLatin1Char('*') || c == QLatin1Char('?')
+            || (c == QLatin1Char('{') && i + 1 < n && pattern.at(i + 1).isDigit())) {
+            // The previous atom may be absent
+            if (lastIsLiteral) run.chop(lastCharacterLength());
+            flush();
+            if (c == QLatin1Char('{')) {
+                const qsizetype end = pattern.indexOf(QLatin1Char('}'), i);
+                i = end < 0 ? n : end + 1;
+            } else {
+                ++i;
+            }
+            if (i < n && (pattern.at(i) == QLatin1Char('?') || pattern.at(i) == QLatin1Char('+'))) ++i;
+            continue;
+        }
+
+        if (c == QLatin1Char('+')) {
+            // At least once: the runs before and after the repetition both hold it
+            const QString last = lastIsLiteral ? run.right(lastCharacterLength()) : QString();
+            flush();
+            run = last;
+            ++i;
+            if (i < n && (pattern.at(i) == QLatin1Char('?') || pattern.at(i) == QLatin1Char('+'))) ++i;
+            continue;
+        }
+
+        if (c == QLatin1Char('|')) {
+            return false;  // Groups are skipped, so this one is at the top level
+        }
+        if (c == QLatin1Char('[')) {
+            flush();
+            i = skipClass(pattern, i);
+            continue;
+        }
+        if (c == QLatin1Char('(')) {
+            flush();
+            i = skipGroup(pattern, i);
+            continue;
+        }
+        if (c == QLatin1Char('.') || c == QLatin1Char('^') || c == QLatin1Char('$') || c == QLatin1Char(')')) {
+            flush();
+            ++i;
+            continue;
+        }
+
+        run.append(c);
+        lastIsLiteral = true;
+        ++i;
+    }
+    flush();
+    return true;
+}
+
+// Merges the sorted `required` trigrams against the delta encoded set
+bool TrigramIndex::containsAll(const QByteArray& encoded, const TrigramSet& required) {
+    const uchar* p = reinterpret_cast<const uchar*>(encoded.constData());
+    const uchar* end = p + encoded.size();
+    qsizetype next = 0;
+    quint32 value = 0;
+
+    while (p < end && next < required.size()) {
+        quint32 delta = 0;
+        int shift = 0;
+        while (p < end && (*p & 0x80)) {
+            delta |= quint32(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        if (p < end) delta |= quint32(*p++) << shift;
+        value += delta;
+
+        if (required.at(next) < value) {
+            return false;  // Passed it without a match
+        }
+        if (required.at(next) == value) {
+            ++next;
+        }
+    }
+    return next == required.size();
+}
+
+void TrigramIndex::indexFile(const QString& filePath, File& file) {
+    file.trigrams.clear();
+    file.indexed = false;
+    file.text = TextClassifier::instance().isText(filePath);
+    if (!file.text || file.size > kMaxIndexedSize) {
+        return;
+    }
+
+    QFile input(filePath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // One bit per possible trigram, reused by every file indexed on this thread
+    thread_local std::vector<quint64> seen(size_t(1) << 18);
+    thread_local std::vector<quint32> found;
+    found.clear();
+
+    quint32 window = 0;
+    int length = 0;     // Bytes in `window` since the last line break
+    bool first = true;
+    while (true) {
+        const QByteArray block = input.read(kBlockSize);
+        if (block.isEmpty()) break;
+        if (first) {
+            first = false;
+            // UTF-16 and UTF-32 text is not in the byte form queries are looked up in
+            if (block.startsWith("\xFF\xFE") || block.startsWith("\xFE\xFF")
+                || block.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4))) {
+                return;
+            }
+        }
+
+        for (const char c : block) {
+            const uchar byte = uchar(c);
+            if (byte == '\n' || byte == '\r') {
+                length = 0;
+                continue;
+            }
+            window = ((window << 8) | foldCase(byte)) & 0xFFFFFF;
+            if (++length >= 3) {
+                quint64& word = seen[window >> 6];
+                const quint64 bit = quint64(1) << (window & 63);
+                if (!(word & bit)) {
+                    word |= bit;
+                    found.push_back(window);
+                }
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end());
+    quint32 previous = 0;
+    for (const quint32 trigram : found) {
+        appendVarint(file.trigrams, trigram - previous);
+        previous = trigram;
+        seen[trigram >> 6] = 0;
+    }
+    file.trigrams.squeeze();
+    file.indexed = input.error() == QFileDevice::NoError;
+}
+
+QString TrigramIndex::indexPath() const {
+    const QByteArray name = QCryptographicHash::hash(m_root.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + QStringLiteral("/trigram-index/") + QString::fromLatin1(name) + QStringLiteral(".idx");
+}
+
+bool TrigramIndex::load() {
+    QFile input(indexPath());
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream in(&input);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0, version = 0;
+    QString root;
+    qint64 count = 0;
+    in >> magic >> version >> root >> count;
+    if (magic != kMagic || version != kVersion || root != m_root || count < 0) {
+        return false;
+    }
+
+    QVector<File> files;
+    files.reserve(count);
+    for (qint64 i = 0; i < count; ++i) {
+        File file;
+        in >> file.path >> file.size >> file.modified >> file.text >> file.indexed >> file.trigrams;
+        if (in.status() != QDataStream::Ok) {
+            return false;
+        }
+        files.append(std::move(file));
+    }
+    m_files = std::move(files);
+    return true;
+}
+
+bool TrigramIndex::save() const {
+    const QString path = indexPath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile output(path);
+    if (!output.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&output);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kMagic << kVersion << m_root << qint64(m_files.size());
+    for (const File& file : m_files) {
+        out << file.path << file.size << file.modified << file.text << file.indexed << file.trigrams;
+    }
+    return out.status() == QDataStream::Ok && output.commit();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArray>
+#include <QPromise>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "searchoptions.h"
+
+// On-disk trigram index of a directory tree, for System Find over folders searched again
+// and again. Each text file is stored with its size, mtime and the sorted set of byte
+// trigrams it contains (ASCII letters folded to lower case, delta and varint encoded).
+// update() re-reads only the files whose size or mtime changed since the last search.
+// candidates() then returns the files holding every trigram the query requires, and
+// only those are searched. The index lives under the application data directory, one
+// file per root.
+class TrigramIndex {
+public:
+    explicit TrigramIndex(const QString& root);
+
+    // Loads the saved index, brings it up to date with the tree and saves it. False when
+    // `promise` was canceled.
+    bool update(const QPromise<void>* promise = nullptr);
+
+    // Absolute paths of files that may hold a match, filtered by file name; their total
+    // size goes to `totalBytes` when given
+    QStringList candidates(const SearchOptions& options, const QRegularExpression& fileNamePattern,
+                           qint64* totalBytes = nullptr) const;
+
+    // True when the query requires at least one trigram, so the index can narrow the search
+    static bool canNarrow(const SearchOptions& options);
+
+    QString root() const;
+
+    // Literal runs every match of a regex must contain; false when it cannot tell
+    static bool regexLiterals(const QString& pattern, QStringList& literals);
+
+private:
+    struct File {
+        QString path;           // Relative to the root
+        qint64 size = 0;
+        qint64 modified = 0;    // Milliseconds since the epoch
+        bool text = false;
+        bool indexed = false;   // Too large or not UTF-8; always a candidate when text
+        QByteArray trigrams;
+    };
+
+    // Alternatives, each a sorted set of trigrams that must all be present; no
+    // alternatives means the query cannot be narrowed
+    using TrigramSet = QVector<quint32>;
+    static QVector<TrigramSet> requiredTrigrams(const SearchOptions& options);
+    static TrigramSet literalTrigrams(const QString& literal, bool fold);
+
+    static bool containsAll(const QByteArray& encoded, const TrigramSet& required);
+    static void indexFile(const QString& filePath, File& file);
+
+    QString indexPath() const;
+    bool load();
+    bool save() const;
+
+    QString m_root;
+    QVector<File> m_files;
+};
@@ -1,12 +1,16 @@
 #include <QFileDialog>
-#include <QDirIterator>
 #include <QProgressBar>
 #include <QLabel>
 #include <QVBoxLayout>
-#include <QMimeDatabase>
 #include <QMessageBox>
+#include <QTime>
+#include <QtConcurrent>
 #include "systemfinddialog.h"
+#include "../search/directorywalker.h"
 #include "../search/filesearchworker.h"
+#include "../search/keywordlist.h"
+#include "../search/patterncache.h"
+#include "../search/trigramindex.h"
 #include "ui_systemfinddialog.h"
 #include "../systemsearchresultdialog.h"
 #include "../settings.h"
@@ -14,12 +18,26 @@
 
 SystemFindDialog::SystemFindDialog(QWidget *parent)
     : QDialog(parent), ui(new Ui::SystemFindDialog)
-    , m_searchOptions(new SearchOptions()), m_files()
-    , m_processedFiles(0), m_find(nullptr), m_systemSearchResultDialog(nullptr)
+    , m_searchOptions(new SearchOptions())
+    , m_processedFiles(0), m_walker(new DirectoryWalker(this))
+    , m_find(nullptr), m_systemSearchResultDialog(nullptr)
 {
     ui->setupUi(this);
 
     connect(this, &SystemFindDialog::updateProgress, this, &SystemFindDialog::updateProgressDisplay);
+    m_resultTimer.setInterval(kResultInterval);
+    connect(&m_resultTimer, &QTimer::timeout, this, &SystemFindDialog::drainResults);
+    connect(m_walker, &DirectoryWalker::progress, this, [this](int filesFound) {
+        m_filesFound = filesFound;
+        emit updateProgress(m_processedFiles, m_filesFound);
+    });
+    connect(m_walker, &DirectoryWalker::finished, this, [this](int filesFound) {
+        qInfo() << "Directory walk finished. Files found:" << filesFound;
+        m_filesFound = filesFound;
+        m_totalBytes = m_walker->bytesFound();
+        ui->m_progressBar->setMaximum(filesFound);
+        emit updateProgress(m_processedFiles, m_filesFound);
+    });
 
     const int move = 220;
     const int reduceHeight = 210;
@@ -30,6 +48,8 @@ SystemFindDialog::SystemFindDialog(QWidget *parent)
     ui->selectAll->move(ui->selectAll->x(), ui->selectAll->y() - move);
     ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() - move);
     ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() - move);
+    ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() - move);
+    ui->m_throughputLabel->move(ui->m_throughputLabel->x(), ui->m_throughputLabel->y() - move);
 
     // Initially hide the advanced options and decrease the form and tabWidget height
     ui->groupBoxAdvanced->hide();
@@ -45,6 +65,7 @@ SystemFindDialog::SystemFindDialog(QWidget *parent)
 
 SystemFindDialog::~SystemFindDialog()
 {
+    stopWalk(); // Workers report to this dialog
     delete ui;
     delete m_find;
     delete m_searchOptions;
@@ -53,6 +74,12 @@ SystemFindDialog::~SystemFindDialog()
 
 void SystemFindDialog::cleanupResources() {
     qInfo() << "Cleaning up resources. Closing window...";
+    stopWalk();
+}
+
+void SystemFindDialog::reject() {
+    cleanupResources();
+    QDialog::reject();
 }
 
 bool SystemFindDialog::eventFilter(QObject *watched, QEvent *event) {
@@ -186,6 +213,8 @@ void SystemFindDialog::toggleAdvancedOptions(bool checked) {
         ui->selectAll->move(ui->selectAll->x(), ui->selectAll->y() + move);
         ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() + move);
         ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() + move);
+        ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() + move);
+        ui->m_throughputLabel->move(ui->m_throughputLabel->x(), ui->m_throughputLabel->y() + move);
 
         resize(width(), height() + increaseHeight);
 
@@ -197,6 +226,8 @@ void SystemFindDialog::toggleAdvancedOptions(bool checked) {
         ui->selectAll->move(ui->selectAll->x(), ui->selectAll->y() - move);
         ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() - move);
         ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() - move);
+        ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() - move);
+        ui->m_throughputLabel->move(ui->m_throughputLabel->x(), ui->m_throughputLabel->y() - move);
 
         resize(width(), height() - increaseHeight);
 
@@ -214,16 +245,8 @@ void SystemFindDialog::on_pushButtonBrowse_clicked()
 }
 
 void SystemFindDialog::startSearchNext(const SearchOptions& options) {
-    if (!m_searchOptions) {
-        m_searchOptions = new SearchOptions();
-    }
     *m_searchOptions = options;
 
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
     // Compile the regex pattern if it's not empty
     QRegularExpression regex;
     if (!m_searchOptions->pattern.isEmpty()) {
@@ -237,106 +260,18 @@ void SystemFindDialog::startSearchNext(const SearchOptions& options) {
         qDebug() << "No pattern provided. All files will be considered.";
     }
 
-    // Prepare flags for QDirIterator
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Process files in the directory
-    QMimeDatabase mimeDb;
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and (if present) regex pattern
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            qInfo() << "Matched file: " << filePath;
-            processFile(filePath);
-        }
-    }
-
-    qInfo() << "Search completed. Total processed files: " << m_processedFiles;
-    ui->m_progressBar->setMaximum(m_processedFiles);
+    startWalk(regex);
 }
 
+// Files are searched in parallel and reported as they finish, so the result order never
+// followed the walk order; walking backwards first would only delay the first hit
 void SystemFindDialog::startSearchPrevious(const SearchOptions& options) {
-    // Store the search options
-    if (!m_searchOptions) {
-        m_searchOptions = new SearchOptions();
-    }
-    *m_searchOptions = options;
-
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
-    // Compile the regex pattern if it's not empty
-    QRegularExpression regex;
-    if (!m_searchOptions->pattern.isEmpty()) {
-        regex.setPattern(m_searchOptions->pattern);
-        if (!regex.isValid()) {
-            qWarning() << "Invalid regex pattern: " << regex.errorString();
-            return;
-        }
-        qDebug() << "Using pattern: " << m_searchOptions->pattern;
-    } else {
-        qDebug() << "No pattern provided. All files will be considered.";
-    }
-
-    // Prepare flags for QDirIterator
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Collect all matching files in a QList
-    QMimeDatabase mimeDb;
-    QList<QString> matchingFiles;
-
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and (if present) regex pattern
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            matchingFiles.append(filePath);
-        }
-    }
-
-    // Reverse iterate through the list of matching files
-    for (auto it = matchingFiles.rbegin(); it != matchingFiles.rend(); ++it) {
-        QString filePath = *it;
-        qDebug() << "Processing file (reverse): " << filePath;
-        processFile(filePath);
-    }
-
-    qInfo() << "Search completed. Total processed files: " << m_processedFiles;
-    ui->m_progressBar->setMaximum(m_processedFiles);
+    startSearchNext(options);
 }
 
 void SystemFindDialog::selectAll(const SearchOptions& options) {
-    // Store the search options
-    if (!m_searchOptions) {
-        m_searchOptions = new SearchOptions();
-    }
     *m_searchOptions = options;
 
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
     // Compile the regex pattern from SearchOptions->pattern
     QRegularExpression regex;
     if (!m_searchOptions->pattern.isEmpty()) {
@@ -350,70 +285,138 @@ void SystemFindDialog::selectAll(const SearchOptions& options) {
         qDebug() << "No pattern provided. Selecting all files.";
     }
 
-    // Prepare flags for QDirIterator to include hidden subdirectories
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
+    startWalk(regex);
+}
 
-    // Process files in the directory
-    QMimeDatabase mimeDb;
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
+// DirectoryWalker lists the tree on its own threads and feeds paths through a bounded
+// queue to search workers on m_threadPool, so hits show up while the walk is running
+void SystemFindDialog::startWalk(const QRegularExpression& fileNamePattern) {
+    stopWalk();
 
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
+    const int generation = ++m_walkGeneration;
+    m_processedFiles = 0;
+    m_filesFound = 0;
+    m_totalBytes = -1;
+    ui->m_progressBar->setMaximum(0); // Busy until the walk knows the total
+    ui->m_progressBar->setValue(0);
+    ui->m_throughputLabel->clear();
+    ui->stopSearch->setEnabled(true);
+
+    m_control = std::make_shared<SearchControl>();
+    m_searchTime.start();
+    m_lastReadout = 0;
+    m_paths = std::make_shared<DirectoryWalker::PathQueue>(kPathQueueCapacity);
+    m_results = std::make_shared<ResultQueue>(kResultQueueCapacity);
+    if (ui->useIndex->isChecked() && m_searchOptions->includeSubdirectories && TrigramIndex::canNarrow(*m_searchOptions)) {
+        startIndexedWalk(fileNamePattern, generation);
+    } else {
+        m_walker->start(m_searchOptions->location, m_searchOptions->includeSubdirectories, fileNamePattern, m_paths);
+    }
 
-        // Match MIME type and pattern (if provided)
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            qInfo() << "Selected file:  " << filePath;
-            processFile(filePath);
-        }
+    // Built here once, rather than by every worker racing for the first file
+    QSharedPointer<const KeywordList> keywordList;
+    if (m_searchOptions->findMethod == FindMethod::KeywordList) {
+        keywordList = PatternCache::instance().keywordList(*m_searchOptions);
     }
 
-    qInfo() << "Select All completed. Total files processed: " << m_processedFiles;
+    for (int i = 0; i < m_threadPool.maxThreadCount(); ++i) {
+        auto* worker = new FileSearchWorker(m_paths, *m_searchOptions);
+        worker->setResultQueue(m_results);
+        worker->setControl(m_control);
+        worker->setKeywordList(keywordList);
+        connect(worker, &FileSearchWorker::filesSearched, this, [this, generation](int count) {
+            if (generation != m_walkGeneration) return;
+            m_processedFiles += count;
+            emit updateProgress(m_processedFiles, m_filesFound);
+        });
+        m_threadPool.start(worker);
+    }
+    m_resultTimer.start();
 }
 
-void SystemFindDialog::countTextFiles(const QString& directory, bool includeSubdirectories, const QRegularExpression& pattern) {
-    QMimeDatabase mimeDb;
-    QDirIterator::IteratorFlags iteratorFlags = includeSubdirectories ?
-                                                    QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
-    QDirIterator it(directory, QDir::Files, iteratorFlags);
+// Brings the folder's trigram index up to date, then queues only the files holding every
+// trigram the query needs. Stat calls replace reading every byte of unchanged files.
+void SystemFindDialog::startIndexedWalk(const QRegularExpression& fileNamePattern, int generation) {
+    ui->m_statusLabel->setText(tr("Updating the search index..."));
 
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
+    m_indexLookup = QtConcurrent::run([this, generation](QPromise<void>& promise, const SearchOptions& options,
+                                                         const QRegularExpression& fileNamePattern,
+                                                         const std::shared_ptr<DirectoryWalker::PathQueue>& paths) {
+        TrigramIndex index(options.location);
+        if (!index.update(&promise)) {
+            return;
+        }
 
-        // Match file name against the pattern
-        if (mimeType.name().startsWith("text/") && pattern.match(fileName).hasMatch()) {
-            m_files.insert(filePath);
+        qint64 totalBytes = 0;
+        const QStringList candidates = index.candidates(options, fileNamePattern, &totalBytes);
+        qInfo() << "Search index narrowed" << index.root() << "to" << candidates.size() << "files";
+        QMetaObject::invokeMethod(this, [this, generation, count = int(candidates.size()), totalBytes]() {
+            if (generation != m_walkGeneration) return;
+            m_filesFound = count;
+            m_totalBytes = totalBytes;
+            ui->m_progressBar->setMaximum(count);
+            emit updateProgress(m_processedFiles, m_filesFound);
+        }, Qt::QueuedConnection);
+
+        for (const QString& path : candidates) {
+            if (!paths->push(path)) return; // Canceled
         }
-    }
+        paths->close();
+    }, *m_searchOptions, fileNamePattern, m_paths);
 }
 
-
-void SystemFindDialog::processFile(const QString& filePath) {
-    m_files.insert(filePath);
-    qInfo() << "*** Included new file: " << filePath;
-
-    m_processedFiles++;
-    emit updateProgress(m_processedFiles, m_files.count());
-
-    auto* worker = new FileSearchWorker(filePath, *m_searchOptions);
-    connect(worker, &FileSearchWorker::fileProcessed, this, &SystemFindDialog::handleFileProcessed);
-    m_threadPool.start(worker);
+// Every stage polls its own flag: the index lookup its promise, the walker and the path
+// queue theirs, and the workers m_control, even in the middle of a file
+void SystemFindDialog::stopWalk() {
+    if (m_control) {
+        m_control->canceled = true;
+    }
+    m_indexLookup.cancel();
+    m_walker->cancel();
+    if (m_paths) {
+        m_paths->cancel(); // Workers waiting for paths return
+        m_paths.reset();
+    }
+    if (m_results) {
+        m_results->close(); // Workers waiting for the GUI to drain return
+    }
+    m_indexLookup.waitForFinished();
+    m_threadPool.waitForDone();
+    m_resultTimer.stop();
+    m_results.reset();
+    ui->stopSearch->setEnabled(false);
 }
 
 void SystemFindDialog::updateProgressDisplay(int processedFiles) {
     ui->m_progressBar->setValue(processedFiles);
-    ui->m_statusLabel->setText(QString("Searching Files... %1/%2").arg(processedFiles).arg(m_files.count()));
+    ui->m_statusLabel->setText(QString("Searching Files... %1/%2").arg(processedFiles).arg(m_filesFound));
 }
 
-void SystemFindDialog::handleFileProcessed(const FileSearchResults& result) {
+// Everything the workers found since the last tick, inserted into the tree at once
+void SystemFindDialog::drainResults() {
+    if (!m_results) return;
+
+    // Read before draining: a worker that pushes its last result and exits in between
+    // would otherwise leave that result behind in the queue
+    const bool workersDone = m_threadPool.activeThreadCount() == 0;
+    const QVector<FileSearchResults> results = m_results->drain();
+    if (results.isEmpty() && workersDone) {
+        m_resultTimer.stop(); // Workers are done and everything was delivered
+        ui->stopSearch->setEnabled(false);
+        updateThroughput();
+        ui->m_statusLabel->setText(tr("Done. %1 files searched").arg(m_control->filesSearched.load()));
+        return;
+    }
+
+    if (m_searchTime.elapsed() - m_lastReadout >= kReadoutInterval) {
+        updateThroughput();
+    }
+    deliverResults(results);
+}
+
+void SystemFindDialog::deliverResults(const QVector<FileSearchResults>& results) {
+    if (results.isEmpty()) return;
+
     // Ensure the result dialog is open in non-modal mode
     if (!m_systemSearchResultDialog) {
         m_systemSearchResultDialog = new SystemSearchResultDialog(this);
@@ -421,8 +424,32 @@ void SystemFindDialog::handleFileProcessed(const FileSearchResults& result) {
         m_systemSearchResultDialog->show();
     }
 
-    // Add each result to the tree view in the dialog
-    m_systemSearchResultDialog->addSearchResult(result);
+    // Add the results to the tree view in the dialog
+    m_systemSearchResultDialog->addSearchResults(results);
+}
+
+// Rates are averages since the search started. The ETA divides the bytes left by the
+// byte rate, so it only shows once the walk (or the index) knows the total.
+void SystemFindDialog::updateThroughput() {
+    if (!m_control) return;
+
+    const qint64 elapsed = qMax<qint64>(m_searchTime.elapsed(), 1);
+    m_lastReadout = elapsed;
+    const double seconds = elapsed / 1000.0;
+    const qint64 bytes = m_control->bytesSearched;
+    const double bytesPerSecond = bytes / seconds;
+
+    QString text = tr("%1 files/s, %2 MB/s, %3 matches")
+                       .arg(qRound(m_control->filesSearched / seconds))
+                       .arg(bytesPerSecond / (1024 * 1024), 0, 'f', 1)
+                       .arg(m_control->matches.load());
+    if (m_resultTimer.isActive() && m_totalBytes >= 0 && bytesPerSecond > 0) {
+        const qint64 remaining = qMax<qint64>(m_totalBytes - bytes, 0);
+        text += tr(", %1 left").arg(QTime(0, 0).addSecs(int(remaining / bytesPerSecond) + 1).toString("h:mm:ss"));
+    } else if (!m_resultTimer.isActive()) {
+        text += tr(" in %1 s").arg(seconds, 0, 'f', 1);
+    }
+    ui->m_throughputLabel->setText(text);
 }
 
 void SystemFindDialog::UpdateSearchOptions() {
@@ -441,6 +468,7 @@ void SystemFindDialog::UpdateSearchOptions() {
         Helpers::notImplemented(this);
         m_searchOptions->findMethod = FindMethod::SpecialCharacters;
     }
+    if (ui->findKeywordList->isChecked()) m_searchOptions->findMethod = FindMethod::KeywordList;
     m_searchOptions->matchWholeWord = ui->matchWholeWord->isChecked();
     m_searchOptions->matchCase = ui->matchCase->isChecked();
     m_searchOptions->includeSubdirectories = ui->includeSubdirectories->isChecked();
@@ -498,7 +526,6 @@ void SystemFindDialog::on_findPrevious_clicked()
 
 void SystemFindDialog::on_selectAll_clicked()
 {
-    m_files.clear();
     m_searchOptions->role = Role::SelectAll;
     UpdateSearchOptions();
     saveHistory();
@@ -506,3 +533,17 @@ void SystemFindDialog::on_selectAll_clicked()
     selectAll(*m_searchOptions);
 }
 
+// What was found before the stop stays in the result dialog
+void SystemFindDialog::on_stopSearch_clicked()
+{
+    const std::shared_ptr<ResultQueue> results = m_results;
+    stopWalk();
+    if (results) {
+        deliverResults(results->drain());
+    }
+    updateThroughput();
+    const int searched = m_control ? m_control->filesSearched.load() : 0;
+    ui->m_statusLabel->setText(tr("Stopped. %1/%2 files searched").arg(searched).arg(m_filesFound));
+    qInfo() << "Search stopped after" << searched << "files";
+}
+
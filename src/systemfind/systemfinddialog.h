@@ -2,10 +2,18 @@
 
 #include <QDebug>
 #include <QDialog>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QRegularExpression>
 #include <QThreadPool>
+#include <QTimer>
 #include <QCloseEvent>
 #include "systemfind.h"
 #include <atomic>
+#include <memory>
+#include "../search/boundedqueue.h"
+#include "../search/resultqueue.h"
+#include "../search/searchcontrol.h"
 #include "../search/searchoptions.h"
 #include "../systemsearchresultdialog.h"
 
@@ -13,6 +21,7 @@ namespace Ui {
 class SystemFindDialog;
 }
 
+class DirectoryWalker;
 class QProgressBar;
 class QLabel;
 
@@ -28,6 +37,9 @@ public:
     void startSearchPrevious(const SearchOptions& options);
     void selectAll(const SearchOptions& options);
 
+public slots:
+    void reject() override; // Escape closes without a closeEvent
+
 protected:
     void closeEvent(QCloseEvent *event) override {
         qWarning() << "Window is closing. Cleaning up resources...";
@@ -40,7 +52,7 @@ signals:
     void updateProgress(int processedFiles, int totalFiles);
 
 private slots:
-    void handleFileProcessed(const FileSearchResults& result);
+    void drainResults();
 
     void updateProgressDisplay(int processedFiles);
 
@@ -56,6 +68,8 @@ private slots:
 
     void on_selectAll_clicked();
 
+    void on_stopSearch_clicked();
+
 private:
     Ui::SystemFindDialog *ui;
 
@@ -73,10 +87,29 @@ private:
     void UpdateSearchOptions();
     void showResultDialog();
 
-    void countTextFiles(const QString& directory, bool includeSubdirectories, const QRegularExpression& pattern);
-    void processFile(const QString& filePath);
-    QSet<QString> m_files;
+    void startWalk(const QRegularExpression& fileNamePattern);
+    void startIndexedWalk(const QRegularExpression& fileNamePattern, int generation);
+    void stopWalk();
+    void deliverResults(const QVector<FileSearchResults>& results);
+    void updateThroughput();
+
+    static constexpr qsizetype kPathQueueCapacity = 4096;
+    static constexpr int kResultQueueCapacity = 65536;   // Buffered match lines
+    static constexpr int kResultInterval = 50;           // Milliseconds between result drains
+    static constexpr int kReadoutInterval = 250;         // Milliseconds between throughput updates
+
     std::atomic<int> m_processedFiles{0};
+    int m_filesFound = 0;
+    int m_walkGeneration = 0;
+    DirectoryWalker* m_walker;
+    std::shared_ptr<BoundedQueue<QString>> m_paths;
+    QFuture<void> m_indexLookup;
+    std::shared_ptr<ResultQueue> m_results;
+    std::shared_ptr<SearchControl> m_control;
+    QElapsedTimer m_searchTime;
+    qint64 m_lastReadout = 0;
+    qint64 m_totalBytes = -1;   // Size of everything to search, once the walk knows it
+    QTimer m_resultTimer;
     QThreadPool m_threadPool;
     SystemFind* m_find;
     SystemSearchResultDialog* m_systemSearchResultDialog;
@@ -1,21 +1,35 @@
 #include <QMessageBox>
 #include <QFileDialog>
-#include <QDirIterator>
-#include <QMimeDatabase>
+#include <QTextStream>
+#include <QCloseEvent>
 #include "../helpers.h"
 #include "../settings.h"
 #include "systemreplacedialog.h"
 #include "ui_systemreplacedialog.h"
+#include "../search/directorywalker.h"
 #include "../search/filesearchworker.h"
+#include "../search/keywordlist.h"
+#include "../search/patterncache.h"
+#include "../search/textclassifier.h"
 
 SystemReplaceDialog::SystemReplaceDialog(QWidget *parent)
     : QDialog(parent), ui(new Ui::SystemReplaceDialog)
-    , m_searchOptions(new SearchOptions()), m_files()
-    , m_processedFiles(0), m_find(nullptr), m_systemSearchResultDialog(nullptr)
+    , m_searchOptions(new SearchOptions())
+    , m_processedFiles(0), m_walker(new DirectoryWalker(this)), m_find(nullptr), m_systemSearchResultDialog(nullptr)
 {
     ui->setupUi(this);
 
     connect(this, &SystemReplaceDialog::updateProgress, this, &SystemReplaceDialog::updateProgressDisplay);
+    connect(m_walker, &DirectoryWalker::progress, this, [this](int filesFound) {
+        m_filesFound = filesFound;
+        emit updateProgress(m_processedFiles, m_filesFound);
+    });
+    connect(m_walker, &DirectoryWalker::finished, this, [this](int filesFound) {
+        qInfo() << "Directory walk finished. Files found:" << filesFound;
+        m_filesFound = filesFound;
+        ui->m_progressBar->setMaximum(filesFound);
+        emit updateProgress(m_processedFiles, m_filesFound);
+    });
 
     const int move = 220;
     const int reduceHeight = 210;
@@ -29,6 +43,7 @@ SystemReplaceDialog::SystemReplaceDialog(QWidget *parent)
     ui->replaceAll->move(ui->replaceAll->x(), ui->replaceAll->y() - move);
     ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() - move);
     ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() - move);
+    ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() - move);
 
     // Initially hide the advanced options and decrease the form and tabWidget height
     ui->groupBoxAdvanced->hide();
@@ -45,12 +60,99 @@ SystemReplaceDialog::SystemReplaceDialog(QWidget *parent)
 
 SystemReplaceDialog::~SystemReplaceDialog()
 {
+    stopSearch(); // Workers report to this dialog
     delete ui;
     delete m_systemSearchResultDialog;
 }
 
 void SystemReplaceDialog::cleanupResources() {
     qInfo() << "Cleaning up resources. Closing window...";
+    stopSearch();
+}
+
+void SystemReplaceDialog::closeEvent(QCloseEvent *event) {
+    cleanupResources();
+    QDialog::closeEvent(event);
+}
+
+void SystemReplaceDialog::reject() {
+    cleanupResources();
+    QDialog::reject();
+}
+
+// DirectoryWalker lists the tree on its own threads and feeds paths through a bounded
+// queue to workers on m_threadPool. Each search gets its own control, so stopping it
+// reaches the walk and every worker, and workers of a stopped search never report into the next.
+void SystemReplaceDialog::startWalk(const QRegularExpression& fileNamePattern, bool replace) {
+    stopSearch();
+
+    const int generation = ++m_walkGeneration;
+    m_processedFiles = 0;
+    m_filesFound = 0;
+    ui->m_progressBar->setMaximum(0); // Busy until the walk knows the total
+    ui->m_progressBar->setValue(0);
+    ui->stopSearch->setEnabled(true);
+
+    m_control = std::make_shared<SearchControl>();
+    m_paths = std::make_shared<DirectoryWalker::PathQueue>(kPathQueueCapacity);
+    m_walker->start(m_searchOptions->location, m_searchOptions->includeSubdirectories, fileNamePattern, m_paths);
+
+    if (replace) {
+        for (int i = 0; i < m_threadPool.maxThreadCount(); ++i) {
+            m_threadPool.start([this, generation, paths = m_paths, control = m_control, options = *m_searchOptions]() {
+                QString filePath;
+                while (!control->isCanceled() && paths->pop(filePath)) {
+                    QString modifiedContent;
+                    const bool modified = TextClassifier::instance().isText(filePath)
+                                          && replaceInFile(filePath, options, modifiedContent);
+                    ++control->filesSearched;
+                    QMetaObject::invokeMethod(this, [this, generation, filePath, modified, modifiedContent]() {
+                        if (generation != m_walkGeneration) return;
+                        if (modified) {
+                            m_modifiedFiles[filePath] = modifiedContent;
+                            markUnsavedChanges();
+                        }
+                        emit updateProgress(++m_processedFiles, m_filesFound);
+                    }, Qt::QueuedConnection);
+                }
+            });
+        }
+        return;
+    }
+
+    // Built here once, rather than by every worker racing for the first file
+    QSharedPointer<const KeywordList> keywordList;
+    if (m_searchOptions->findMethod == FindMethod::KeywordList) {
+        keywordList = PatternCache::instance().keywordList(*m_searchOptions);
+    }
+
+    for (int i = 0; i < m_threadPool.maxThreadCount(); ++i) {
+        auto* worker = new FileSearchWorker(m_paths, *m_searchOptions);
+        worker->setControl(m_control);
+        worker->setKeywordList(keywordList);
+        connect(worker, &FileSearchWorker::fileProcessed, this, &SystemReplaceDialog::handleFileProcessed);
+        connect(worker, &FileSearchWorker::filesSearched, this, [this, generation](int count) {
+            if (generation != m_walkGeneration) return;
+            m_processedFiles += count;
+            emit updateProgress(m_processedFiles, m_filesFound);
+        });
+        m_threadPool.start(worker);
+    }
+}
+
+// Every stage polls its own flag: the walker and the path queue theirs, and the
+// workers m_control, even in the middle of a file
+void SystemReplaceDialog::stopSearch() {
+    if (m_control) {
+        m_control->canceled = true;
+    }
+    m_walker->cancel();
+    if (m_paths) {
+        m_paths->cancel(); // Workers waiting for paths return
+        m_paths.reset();
+    }
+    m_threadPool.waitForDone();
+    ui->stopSearch->setEnabled(false);
 }
 
 bool SystemReplaceDialog::eventFilter(QObject *watched, QEvent *event) {
@@ -221,6 +323,7 @@ void SystemReplaceDialog::toggleAdvancedOptions(bool checked) {
         ui->replaceAll->move(ui->replaceAll->x(), ui->replaceAll->y() + move);
         ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() + move);
         ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() + move);
+        ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() + move);
 
         resize(width(), height() + increaseHeight);
 
@@ -235,6 +338,7 @@ void SystemReplaceDialog::toggleAdvancedOptions(bool checked) {
         ui->replaceAll->move(ui->replaceAll->x(), ui->replaceAll->y() - move);
         ui->m_statusLabel->move(ui->m_statusLabel->x(), ui->m_statusLabel->y() - move);
         ui->m_progressBar->move(ui->m_progressBar->x(), ui->m_progressBar->y() - move);
+        ui->stopSearch->move(ui->stopSearch->x(), ui->stopSearch->y() - move);
 
         resize(width(), height() - increaseHeight);
 
@@ -257,11 +361,6 @@ void SystemReplaceDialog::startSearchNext(const SearchOptions& options) {
     }
     *m_searchOptions = options;
 
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
     // Compile the regex pattern if it's not empty
     QRegularExpression regex;
     if (!m_searchOptions->pattern.isEmpty()) {
@@ -275,32 +374,7 @@ void SystemReplaceDialog::startSearchNext(const SearchOptions& options) {
         qDebug() << "No pattern provided. All files will be considered.";
     }
 
-    // Prepare flags for QDirIterator
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Process files in the directory
-    QMimeDatabase mimeDb;
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and (if present) regex pattern
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            qInfo() << "Matched file: " << filePath;
-            processFile(filePath);
-        }
-    }
-
-    qInfo() << "Search completed. Total processed files: " << m_processedFiles;
-    ui->m_progressBar->setMaximum(m_processedFiles);
+    startWalk(regex, false);
 }
 
 void SystemReplaceDialog::on_replaceNext_clicked()
@@ -329,64 +403,10 @@ void SystemReplaceDialog::on_findPrevious_clicked()
     showResultDialog();
 }
 
+// Files are searched in parallel and reported as they finish, so the result order never
+// followed the walk order; walking backwards first would only delay the first hit
 void SystemReplaceDialog::startSearchPrevious(const SearchOptions& options) {
-    // Store the search options
-    if (!m_searchOptions) {
-        m_searchOptions = new SearchOptions();
-    }
-    *m_searchOptions = options;
-
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
-    // Compile the regex pattern if it's not empty
-    QRegularExpression regex;
-    if (!m_searchOptions->pattern.isEmpty()) {
-        regex.setPattern(m_searchOptions->pattern);
-        if (!regex.isValid()) {
-            qWarning() << "Invalid regex pattern: " << regex.errorString();
-            return;
-        }
-        qDebug() << "Using pattern: " << m_searchOptions->pattern;
-    } else {
-        qDebug() << "No pattern provided. All files will be considered.";
-    }
-
-    // Prepare flags for QDirIterator
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Collect all matching files in a QList
-    QMimeDatabase mimeDb;
-    QList<QString> matchingFiles;
-
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and (if present) regex pattern
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            matchingFiles.append(filePath);
-        }
-    }
-
-    // Reverse iterate through the list of matching files
-    for (auto it = matchingFiles.rbegin(); it != matchingFiles.rend(); ++it) {
-        QString filePath = *it;
-        qDebug() << "Processing file (reverse): " << filePath;
-        processFile(filePath);
-    }
-
-    qInfo() << "Search completed. Total processed files: " << m_processedFiles;
-    ui->m_progressBar->setMaximum(m_processedFiles);
+    startSearchNext(options);
 }
 
 void SystemReplaceDialog::on_replacePrevious_clicked()
@@ -409,11 +429,6 @@ void SystemReplaceDialog::selectAll(const SearchOptions& options) {
     }
     *m_searchOptions = options;
 
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
     // Compile the regex pattern from SearchOptions->pattern
     QRegularExpression regex;
     if (!m_searchOptions->pattern.isEmpty()) {
@@ -427,31 +442,7 @@ void SystemReplaceDialog::selectAll(const SearchOptions& options) {
         qDebug() << "No pattern provided. Selecting all files.";
     }
 
-    // Prepare flags for QDirIterator to include hidden subdirectories
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Process files in the directory
-    QMimeDatabase mimeDb;
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and pattern (if provided)
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            qInfo() << "Selected file:  " << filePath;
-            processFile(filePath);
-        }
-    }
-
-    qInfo() << "Select All completed. Total files processed: " << m_processedFiles;
+    startWalk(regex, false);
 }
 
 void SystemReplaceDialog::replaceAll(const SearchOptions& options) {
@@ -461,11 +452,6 @@ void SystemReplaceDialog::replaceAll(const SearchOptions& options) {
     }
     *m_searchOptions = options;
 
-    // Reset processed files count
-    m_processedFiles = 0;
-    m_files.clear();
-    ui->m_progressBar->setValue(0);
-
     // Compile the regex pattern from SearchOptions->pattern
     QRegularExpression regex;
     if (!m_searchOptions->pattern.isEmpty()) {
@@ -479,67 +465,12 @@ void SystemReplaceDialog::replaceAll(const SearchOptions& options) {
         qDebug() << "No pattern provided. Replacing in all files.";
     }
 
-    // Prepare flags for QDirIterator to include hidden subdirectories
-    QDirIterator::IteratorFlags flags = m_searchOptions->includeSubdirectories
-                                            ? QDirIterator::Subdirectories
-                                            : QDirIterator::NoIteratorFlags;
-
-    QDir::Filters dirFilters = QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot;
-
-    // Process files in the directory
-    QMimeDatabase mimeDb;
-    QDirIterator it(m_searchOptions->location, dirFilters, flags);
-
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match MIME type and pattern (if provided)
-        if (mimeType.name().startsWith("text/") &&
-            (m_searchOptions->pattern.isEmpty() || regex.match(fileName).hasMatch())) {
-            qInfo() << "Processing file for replace: " << filePath;
-            replaceInFile(filePath);
-        }
-    }
-
-    qInfo() << "Replace All completed. Total files processed: " << m_processedFiles;
-}
-
-
-void SystemReplaceDialog::countTextFiles(const QString& directory, bool includeSubdirectories, const QRegularExpression& pattern) {
-    QMimeDatabase mimeDb;
-    QDirIterator::IteratorFlags iteratorFlags = includeSubdirectories ?
-                                                    QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
-    QDirIterator it(directory, QDir::Files, iteratorFlags);
-
-    while (it.hasNext()) {
-        QString filePath = it.next();
-        QString fileName = QFileInfo(filePath).fileName();
-        QMimeType mimeType = mimeDb.mimeTypeForFile(filePath);
-
-        // Match file name against the pattern
-        if (mimeType.name().startsWith("text/") && pattern.match(fileName).hasMatch()) {
-            m_files.insert(filePath);
-        }
-    }
-}
-
-void SystemReplaceDialog::processFile(const QString& filePath) {
-    m_files.insert(filePath);
-    qInfo() << "*** Included new file: " << filePath;
-
-    m_processedFiles++;
-    emit updateProgress(m_processedFiles, m_files.count());
-
-    auto* worker = new FileSearchWorker(filePath, *m_searchOptions);
-    connect(worker, &FileSearchWorker::fileProcessed, this, &SystemReplaceDialog::handleFileProcessed);
-    m_threadPool.start(worker);
+    startWalk(regex, true);
 }
 
 void SystemReplaceDialog::updateProgressDisplay(int processedFiles) {
     ui->m_progressBar->setValue(processedFiles);
-    ui->m_statusLabel->setText(QString("Searching Files... %1/%2").arg(processedFiles).arg(m_files.count()));
+    ui->m_statusLabel->setText(QString("Searching Files... %1/%2").arg(processedFiles).arg(m_filesFound));
 }
 
 void SystemReplaceDialog::handleFileProcessed(const FileSearchResults& result) {
@@ -615,7 +546,6 @@ void SystemReplaceDialog::on_findNext_clicked()
 
 void SystemReplaceDialog::on_selectAll_clicked()
 {
-    m_files.clear();
     m_searchOptions->role = Role::SelectAll;
     UpdateSearchOptions();
     saveHistory();
@@ -636,15 +566,24 @@ void SystemReplaceDialog::on_replaceAll_clicked()
     showResultDialog();
 }
 
+void SystemReplaceDialog::on_stopSearch_clicked()
+{
+    stopSearch();
+    const int searched = m_control ? m_control->filesSearched.load() : 0;
+    ui->m_statusLabel->setText(tr("Stopped. %1/%2 files searched").arg(searched).arg(m_filesFound));
+    qInfo() << "Search stopped after" << searched << "files";
+}
+
 void SystemReplaceDialog::markUnsavedChanges() {
     m_unsavedChanges = true;
 }
 
-void SystemReplaceDialog::replaceInFile(const QString& filePath) {
+// Runs on the pool; the caller records the result on the GUI thread
+bool SystemReplaceDialog::replaceInFile(const QString& filePath, const SearchOptions& options, QString& modifiedContent) {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         qWarning() << "Failed to open file for reading: " << filePath;
-        return;
+        return false;
     }
 
     QTextStream in(&file);
@@ -652,26 +591,19 @@ void SystemReplaceDialog::replaceInFile(const QString& filePath) {
     file.close();
 
     // Perform replacements in memory
-    QString modifiedContent = fileContent;
+    modifiedContent = fileContent;
     QRegularExpression searchRegex(
-        QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions->keyword)),
-        m_searchOptions->matchCase ? QRegularExpression::NoPatternOption
-                                   : QRegularExpression::CaseInsensitiveOption
+        QString("\\b%1\\b").arg(QRegularExpression::escape(options.keyword)),
+        options.matchCase ? QRegularExpression::NoPatternOption
+                          : QRegularExpression::CaseInsensitiveOption
         );
 
-    modifiedContent.replace(searchRegex, m_searchOptions->replaceText);
+    modifiedContent.replace(searchRegex, options.replaceText);
 
     if (modifiedContent != fileContent) {
-        // Update the map of modified files
-        m_modifiedFiles[filePath] = modifiedContent;
-        markUnsavedChanges(); // Properly call the method here
         qInfo() << "Replaced content in memory for file: " << filePath;
-    } else {
-        qInfo() << "No changes made to file: " << filePath;
+        return true;
     }
-
-    m_processedFiles++;
-    ui->m_progressBar->setValue(m_processedFiles);
+    qInfo() << "No changes made to file: " << filePath;
+    return false;
 }
-
-
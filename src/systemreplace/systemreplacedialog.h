@@ -1,7 +1,13 @@
 #pragma once
 #include <QDialog>
+#include <QRegularExpression>
+#include <QSharedPointer>
 #include <QThreadPool>
+#include <atomic>
+#include <memory>
 #include "systemreplace.h"
+#include "../search/boundedqueue.h"
+#include "../search/searchcontrol.h"
 #include "../search/searchoptions.h"
 #include "../systemsearchresultdialog.h"
 
@@ -9,6 +15,8 @@ namespace Ui {
 class SystemReplaceDialog;
 }
 
+class DirectoryWalker;
+
 class SystemReplaceDialog : public QDialog
 {
     Q_OBJECT
@@ -25,7 +33,12 @@ public:
     void replaceAll(const SearchOptions& options);
     void markUnsavedChanges();
 
+public slots:
+    void reject() override; // Escape closes without a closeEvent
+
 protected:
+    void closeEvent(QCloseEvent *event) override;
+
     QMap<QString, QString> m_modifiedFiles;
     bool m_unsavedChanges;
 
@@ -55,6 +68,8 @@ private slots:
 
     void on_replaceAll_clicked();
 
+    void on_stopSearch_clicked();
+
 private:
     Ui::SystemReplaceDialog *ui;
 
@@ -72,14 +87,20 @@ private:
     void populateComboBoxLocation();
     void populateComboBoxPattern();
 
-    void countTextFiles(const QString& directory, bool includeSubdirectories, const QRegularExpression& pattern);
     void UpdateSearchOptions();
-    void processFile(const QString& filePath);
-    void replaceInFile(const QString& filePath);
+    void startWalk(const QRegularExpression& fileNamePattern, bool replace);
+    void stopSearch();
+    static bool replaceInFile(const QString& filePath, const SearchOptions& options, QString& modifiedContent);
     void showResultDialog();
     void saveHistory();
-    QSet<QString> m_files;
+    static constexpr qsizetype kPathQueueCapacity = 4096;
+
     std::atomic<int> m_processedFiles{0};
+    int m_filesFound = 0;
+    int m_walkGeneration = 0;
+    DirectoryWalker* m_walker;
+    std::shared_ptr<BoundedQueue<QString>> m_paths;
+    std::shared_ptr<SearchControl> m_control;
     QThreadPool m_threadPool;
     SystemReplace* m_find;
     SystemSearchResultDialog* m_systemSearchResultDialog;
@@ -1,8 +1,8 @@
 #include "systemsearchresultdialog.h"
 #include "ui_systemsearchresultdialog.h"
 #include "systemtextdelegate.h"
+#include "systemsearchresultmodel.h"
 #include <QRegularExpression>
-#include <QStandardItem>
 #include <QMessageBox>
 #include <QFile>
 
@@ -10,15 +10,11 @@ SystemSearchResultDialog::SystemSearchResultDialog(QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::SystemSearchResultDialog)
     , m_unsavedChanges(false)
-    , m_resultModel(new QStandardItemModel(this))
+    , m_resultModel(new SystemSearchResultModel(this))
 {
     ui->setupUi(this);
 
-    m_treeModel = new QStandardItemModel(this);
-    ui->resultTreeView->setModel(m_treeModel);
-
     // Set up the model for the tree view
-    m_resultModel->setHorizontalHeaderLabels({"File Path", "Matches"});
     ui->resultTreeView->setModel(m_resultModel);
 
     // Enable interactive resizing and allow moving columns
@@ -46,9 +42,7 @@ SystemSearchResultDialog::SystemSearchResultDialog(QWidget *parent)
 
     // Apply the custom text delegate
     ui->resultTreeView->setItemDelegate(new SystemTextDelegate(this));
-    ui->resultTreeView->setUniformRowHeights(false); // Allow rows to have variable heights
-    ui->resultTreeView->resizeColumnToContents(0);  // Ensure columns fit the content
-    ui->resultTreeView->doItemsLayout();
+    ui->resultTreeView->setUniformRowHeights(true); // Only the first row is measured
 
     connect(ui->resultTreeView, &QTreeView::doubleClicked, this, &SystemSearchResultDialog::handleDoubleClick);
 }
@@ -121,73 +115,26 @@ void SystemSearchResultDialog::closeEvent(QCloseEvent *event) {
     }
 }
 
-// TODO: Pass SearchOptions to this function so it can highlight all keywords.
 void SystemSearchResultDialog::addSearchResult(const FileSearchResults &result) {
-    if (result.matches.isEmpty()) {
+    if (result.lines.isEmpty()) {
         qWarning() << "No matches found for file:" << result.filePath;
         return;
     }
 
-    QStandardItem *filePathItem = new QStandardItem(result.filePath);
-    filePathItem->setFlags(filePathItem->flags() | Qt::ItemIsSelectable);
-
-    QStandardItem *matchCountItem = new QStandardItem(QString::number(result.matchCount));
-    matchCountItem->setFlags(matchCountItem->flags() | Qt::ItemIsSelectable);
-
-    int firstKeywordLineNumber = -1; // To track the first match line number
-
-    // Iterate through the matches to populate the result model
-    for (const auto &[lineNumber, lineContent] : result.matches) {
-        qInfo() << "addSearchResult lineContent input: " << lineContent;
-
-        QString highlightedLine = lineContent;
-        QRegularExpression pattern(
-            QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword)),
-            m_searchOptions.matchCase
-                ? QRegularExpression::NoPatternOption
-                : QRegularExpression::CaseInsensitiveOption);
-
-        QString processedLine;
-        int lastPos = 0;
-
-        // Highlight the matches manually
-        QRegularExpressionMatchIterator it = pattern.globalMatch(highlightedLine);
-        while (it.hasNext()) {
-            QRegularExpressionMatch match = it.next();
-            processedLine += highlightedLine.mid(lastPos, match.capturedStart() - lastPos);
-            processedLine += QStringLiteral("<span style='background-color: yellow;'>%1</span>")
-                                 .arg(match.captured(0));
-            lastPos = match.capturedEnd();
-        }
-        processedLine += highlightedLine.mid(lastPos); // Append the remaining part
-
-        QStandardItem *lineItem = new QStandardItem();
-        lineItem->setFlags(lineItem->flags() | Qt::ItemIsSelectable);
-        lineItem->setData(processedLine, Qt::DisplayRole); // Highlighted line content
-        lineItem->setData(lineNumber + 1, Qt::UserRole);   // Line number (1-based)
-
-        QStandardItem *matchesItem = new QStandardItem(QString::number(1));
-        matchesItem->setFlags(matchesItem->flags() | Qt::ItemIsSelectable);
-
-        filePathItem->appendRow({lineItem, matchesItem});
-
-        // Store the first keyword's line number (1-based)
-        if (firstKeywordLineNumber == -1) {
-            firstKeywordLineNumber = lineNumber + 1; // Convert to 1-based
-        }
-    }
-
-    // Add the file path and match count as a top-level item
-    m_resultModel->appendRow({filePathItem, matchCountItem});
+    m_resultModel->addResult(result);
 
     qDebug() << "File:" << result.filePath
              << "Reported matches:" << result.matchCount
-             << "First keyword line number:" << firstKeywordLineNumber;
+             << "First keyword line number:" << result.lines.first().lineNumber + 1;
+}
 
-    // Highlight the first match in the editor
-    if (firstKeywordLineNumber > 0) {
-        qDebug() << "First keyword found at line:" << firstKeywordLineNumber << "in file:" << result.filePath;
-    }
+void SystemSearchResultDialog::addSearchResults(const QVector<FileSearchResults> &results) {
+    m_resultModel->addResults(results);
+    qDebug() << "Added" << results.size() << "files to the search results";
+}
+
+void SystemSearchResultDialog::setLoadLinesFromFiles(bool loadLines) {
+    m_resultModel->setLoadLinesFromFiles(loadLines);
 }
 
 // FIXME: Line number is wrong
@@ -207,16 +154,11 @@ void SystemSearchResultDialog::handleDoubleClick(const QModelIndex &index) {
         return;
     }
 
-    // Retrieve the file path from the parent item
-    QStandardItem *parentItem = m_resultModel->itemFromIndex(parentIndex);
-    if (!parentItem) {
-        qWarning() << "Failed to retrieve parent item for index:" << index;
-        return;
-    }
-    QString filePath = parentItem->text();
+    // Retrieve the file path of the line
+    QString filePath = m_resultModel->filePathOfLine(m_resultModel->lineIndex(index));
 
     // Retrieve the line number from the clicked sub-item
-    QVariant lineData = index.data(Qt::UserRole);
+    QVariant lineData = index.data(SystemSearchResultModel::LineNumberRole);
     if (!lineData.isValid()) {
         qWarning() << "No valid line number data for index:" << index;
         return;
@@ -239,26 +181,10 @@ void SystemSearchResultDialog::setSearchOptions(SearchOptions searchOptions) {
 
 void SystemSearchResultDialog::traverseKeywords(bool backward) {
     static int currentKeywordIndex = -1; // Tracks the current keyword index
-    static QModelIndex previousItemIndex; // Tracks the previously highlighted index
-
-    // Reset the highlight of the previous item if it exists
-    if (previousItemIndex.isValid()) {
-        QStandardItem* previousItem = m_resultModel->itemFromIndex(previousItemIndex);
-        if (previousItem) {
-            QString originalText = previousItem->data(Qt::UserRole + 1).toString();
-            if (!originalText.isEmpty()) {
-                previousItem->setData(originalText, Qt::EditRole); // Restore original text
-            }
-        }
-    }
 
-    // Count total matches to handle wraparound
-    int totalMatches = 0;
-    for (int row = 0; row < m_resultModel->rowCount(); ++row) {
-        QStandardItem* fileItem = m_resultModel->item(row, 0);
-        if (!fileItem) continue;
-        totalMatches += fileItem->rowCount();
-    }
+    // One row per matching line, in file order
+    const int totalMatches = m_resultModel->lineCount();
+    if (totalMatches == 0) return;
 
     // Adjust the keyword index based on the traversal direction
     if (backward) {
@@ -273,66 +199,19 @@ void SystemSearchResultDialog::traverseKeywords(bool backward) {
         }
     }
 
-    // Find and highlight the corresponding match
-    int matchCounter = 0;
-    QModelIndex nextItemIndex;
-    for (int row = 0; row < m_resultModel->rowCount(); ++row) {
-        QStandardItem* fileItem = m_resultModel->item(row, 0);
-        if (!fileItem) continue;
-
-        for (int subRow = 0; subRow < fileItem->rowCount(); ++subRow) {
-            QStandardItem* lineItem = fileItem->child(subRow, 0);
-            if (!lineItem) continue;
-
-            if (matchCounter == currentKeywordIndex) {
-                nextItemIndex = m_resultModel->indexFromItem(lineItem);
-
-                // Highlight the keyword with a cyan background
-                QString lineText = lineItem->data(Qt::EditRole).toString();
-                QString originalText = lineItem->data(Qt::UserRole + 1).toString();
-                if (originalText.isEmpty()) {
-                    originalText = lineText;
-                    lineItem->setData(originalText, Qt::UserRole + 1); // Store original text
-                }
-
-                QString highlightedLine = originalText;
-                highlightedLine.replace(
-                    QRegularExpression(QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword))),
-                    QString("<span style='background-color: cyan; color: black;'>%1</span>").arg(m_searchOptions.keyword));
-
-                lineItem->setData(highlightedLine, Qt::EditRole);
-
-                // Scroll to and select the highlighted item
-                ui->resultTreeView->scrollTo(nextItemIndex);
-                ui->resultTreeView->setCurrentIndex(nextItemIndex);
-
-                previousItemIndex = nextItemIndex; // Save the current item for the next call
-                return;
-            }
-
-            matchCounter++;
-        }
-    }
-}
-
-QString SystemSearchResultDialog::removeHtmlTags(const QString& text) {
-    static const QRegularExpression htmlTagRegex("<[^>]*>");
-    QString cleanedText = text;
-    cleanedText.remove(htmlTagRegex);
-    return cleanedText;
+    // Highlight the line's matches in cyan, scroll to and select it
+    m_resultModel->setCurrentLine(currentKeywordIndex);
+    const QModelIndex nextItemIndex = m_resultModel->indexOfLine(currentKeywordIndex);
+    ui->resultTreeView->scrollTo(nextItemIndex);
+    ui->resultTreeView->setCurrentIndex(nextItemIndex);
 }
 
 void SystemSearchResultDialog::traverseAndReplaceKeywords(bool backward) {
     static int currentKeywordIndex = -1; // Tracks the current keyword index
-    static QModelIndex previousItemIndex; // Tracks the previously highlighted index
 
     // Calculate total matches
-    int totalMatches = 0;
-    for (int row = 0; row < m_resultModel->rowCount(); ++row) {
-        QStandardItem* fileItem = m_resultModel->item(row, 0);
-        if (!fileItem) continue;
-        totalMatches += fileItem->rowCount(); // Count sub-items (lines)
-    }
+    const int totalMatches = m_resultModel->lineCount();
+    if (totalMatches == 0) return;
 
     // Adjust the index for forward or backward traversal
     if (backward) {
@@ -346,141 +225,96 @@ void SystemSearchResultDialog::traverseAndReplaceKeywords(bool backward) {
     qDebug() << "Total matches:" << totalMatches;
     qDebug() << "Current keyword index:" << currentKeywordIndex;
 
-    // Traverse matches
-    int matchCounter = 0;
-    QModelIndex nextItemIndex;
-    for (int row = 0; row < m_resultModel->rowCount(); ++row) {
-        QStandardItem* fileItem = m_resultModel->item(row, 0);
-        if (!fileItem) continue;
-
-        QString filePath = fileItem->text();
-        QString fileContent = m_modifiedFiles.value(filePath);
-
-        for (int subRow = 0; subRow < fileItem->rowCount(); ++subRow) {
-            QStandardItem* lineItem = fileItem->child(subRow, 0);
-            if (!lineItem) continue;
-
-            if (matchCounter == currentKeywordIndex) {
-                nextItemIndex = m_resultModel->indexFromItem(lineItem);
-
-                // Retrieve the line content and line number
-                QString lineText = lineItem->data(Qt::EditRole).toString();
-                int lineNumber = lineItem->data(Qt::UserRole).toInt() - 1; // Convert to 0-based index
-
-                qDebug() << "Processing line:" << lineText << "at line number:" << lineNumber;
-
-                // Remove <highlight> tags from the line
-                QString cleanLine = lineText;
-                static QRegularExpression htmlTagRegex("<[^>]*>");
-                cleanLine.remove(htmlTagRegex);
-                qDebug() << "Cleaned line text:" << cleanLine;
-
-                // Replace keyword in the cleaned line content
-                QRegularExpression regex(
-                    QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword)),
-                    m_searchOptions.matchCase ? QRegularExpression::NoPatternOption
-                                              : QRegularExpression::CaseInsensitiveOption
-                    );
-
-                QString replacedText = cleanLine;
-                replacedText.replace(regex, m_searchOptions.replaceText);
-                qDebug() << "Replaced line text:" << replacedText;
-
-                if (replacedText != cleanLine) {
-                    // Update tree view
-                    lineItem->setData(replacedText, Qt::EditRole);
-                    qDebug() << "Updated line in tree view to:" << replacedText;
-
-                    // Update in-memory file content
-                    QStringList fileLines = fileContent.split('\n');
-                    if (lineNumber >= 0 && lineNumber < fileLines.size()) {
-                        fileLines[lineNumber] = replacedText;
-                        m_modifiedFiles[filePath] = fileLines.join('\n');
-                        qDebug() << "Updated file content in memory for:" << filePath;
-                    }
-
-                    markUnsavedChanges();
-                } else {
-                    qDebug() << "No replacement made for line:" << cleanLine;
-                }
-
-                // Scroll to and select the item
-                ui->resultTreeView->scrollTo(nextItemIndex);
-                ui->resultTreeView->setCurrentIndex(nextItemIndex);
-
-                previousItemIndex = nextItemIndex; // Save current item index
-                return;
-            }
-
-            matchCounter++;
+    // Retrieve the line content and line number
+    const QString filePath = m_resultModel->filePathOfLine(currentKeywordIndex);
+    const QString lineText = m_resultModel->lineText(currentKeywordIndex);
+    const int lineNumber = m_resultModel->lineNumber(currentKeywordIndex);
+
+    qDebug() << "Processing line:" << lineText << "at line number:" << lineNumber;
+
+    // Replace keyword in the line content
+    QRegularExpression regex(
+        QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword)),
+        m_searchOptions.matchCase ? QRegularExpression::NoPatternOption
+                                  : QRegularExpression::CaseInsensitiveOption
+        );
+
+    QString replacedText = lineText;
+    replacedText.replace(regex, m_searchOptions.replaceText);
+    qDebug() << "Replaced line text:" << replacedText;
+
+    if (replacedText != lineText) {
+        // Update tree view
+        m_resultModel->setLineText(currentKeywordIndex, replacedText);
+        qDebug() << "Updated line in tree view to:" << replacedText;
+
+        // Update in-memory file content
+        QStringList fileLines = m_modifiedFiles.value(filePath).split('\n');
+        if (lineNumber >= 0 && lineNumber < fileLines.size()) {
+            fileLines[lineNumber] = replacedText;
+            m_modifiedFiles[filePath] = fileLines.join('\n');
+            qDebug() << "Updated file content in memory for:" << filePath;
         }
+
+        markUnsavedChanges();
+    } else {
+        qDebug() << "No replacement made for line:" << lineText;
     }
 
-    qDebug() << "Traversal completed. No match found for current index:" << currentKeywordIndex;
+    // Scroll to and select the item
+    const QModelIndex nextItemIndex = m_resultModel->indexOfLine(currentKeywordIndex);
+    ui->resultTreeView->scrollTo(nextItemIndex);
+    ui->resultTreeView->setCurrentIndex(nextItemIndex);
 }
 
 void SystemSearchResultDialog::replaceAllKeywords() {
     qDebug() << "Starting replace all keywords";
 
-    // Iterate over all rows in the result model
-    for (int row = 0; row < m_resultModel->rowCount(); ++row) {
-        QStandardItem* fileItem = m_resultModel->item(row, 0);
-        if (!fileItem) continue;
-
-        QString filePath = fileItem->text();
-        QString fileContent = m_modifiedFiles.value(filePath);
-        QStringList fileLines = fileContent.split('\n');
-        bool fileModified = false;
-
-        // Iterate over sub-items (lines) in each file
-        for (int subRow = 0; subRow < fileItem->rowCount(); ++subRow) {
-            QStandardItem* lineItem = fileItem->child(subRow, 0);
-            if (!lineItem) continue;
-
-            // Retrieve the line content and line number
-            QString lineText = lineItem->data(Qt::EditRole).toString();
-            int lineNumber = lineItem->data(Qt::UserRole).toInt() - 1; // Convert to 0-based index
-
-            qDebug() << "Processing line:" << lineText << "at line number:" << lineNumber;
-
-            // Remove <highlight> tags from the line
-            QString cleanLine = lineText;
-            static QRegularExpression htmlTagRegex("<[^>]*>");
-            cleanLine.remove(htmlTagRegex);
-            qDebug() << "Cleaned line text:" << cleanLine;
-
-            // Replace keyword in the cleaned line content
-            QRegularExpression regex(
-                QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword)),
-                m_searchOptions.matchCase ? QRegularExpression::NoPatternOption
-                                          : QRegularExpression::CaseInsensitiveOption
-                );
-
-            QString replacedText = cleanLine;
-            replacedText.replace(regex, m_searchOptions.replaceText);
-            qDebug() << "Replaced line text:" << replacedText;
-
-            if (replacedText != cleanLine) {
-                // Update tree view
-                lineItem->setData(replacedText, Qt::EditRole);
-                qDebug() << "Updated line in tree view to:" << replacedText;
-
-                // Update in-memory file content
-                if (lineNumber >= 0 && lineNumber < fileLines.size()) {
-                    fileLines[lineNumber] = replacedText;
-                    fileModified = true;
-                }
-            } else {
-                qDebug() << "No replacement made for line:" << cleanLine;
-            }
-        }
-
-        // If the file was modified, update m_modifiedFiles
+    // Replace keyword in the line content
+    QRegularExpression regex(
+        QString("\\b%1\\b").arg(QRegularExpression::escape(m_searchOptions.keyword)),
+        m_searchOptions.matchCase ? QRegularExpression::NoPatternOption
+                                  : QRegularExpression::CaseInsensitiveOption
+        );
+
+    // Lines are grouped by file, so each file's content is split and joined once
+    QString filePath;
+    QStringList fileLines;
+    bool fileModified = false;
+    const auto storeFile = [&]() {
         if (fileModified) {
             m_modifiedFiles[filePath] = fileLines.join('\n');
             qDebug() << "Updated file content in memory for:" << filePath;
         }
+    };
+
+    for (int line = 0; line < m_resultModel->lineCount(); ++line) {
+        if (m_resultModel->filePathOfLine(line) != filePath) {
+            storeFile();
+            filePath = m_resultModel->filePathOfLine(line);
+            fileLines = m_modifiedFiles.value(filePath).split('\n');
+            fileModified = false;
+        }
+
+        // Retrieve the line content and line number
+        const QString lineText = m_resultModel->lineText(line);
+        const int lineNumber = m_resultModel->lineNumber(line);
+
+        QString replacedText = lineText;
+        replacedText.replace(regex, m_searchOptions.replaceText);
+
+        if (replacedText != lineText) {
+            // Update tree view
+            m_resultModel->setLineText(line, replacedText);
+
+            // Update in-memory file content
+            if (lineNumber >= 0 && lineNumber < fileLines.size()) {
+                fileLines[lineNumber] = replacedText;
+                fileModified = true;
+            }
+        }
     }
+    storeFile();
 
     markUnsavedChanges(); // Ensure unsaved changes are marked
     qDebug() << "Replace all keywords completed.";
@@ -2,12 +2,13 @@
 
 #include <QDebug>
 #include <QDialog>
-#include <QStandardItemModel>
 #include <QTreeView>
 #include <QModelIndex>
 #include <QCloseEvent>
 #include "search/searchoptions.h"
 
+class SystemSearchResultModel;
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class SystemSearchResultDialog; }
 QT_END_NAMESPACE
@@ -21,6 +22,8 @@ public:
     ~SystemSearchResultDialog();
 
     void addSearchResult(const FileSearchResults &result);
+    void addSearchResults(const QVector<FileSearchResults> &results);
+    void setLoadLinesFromFiles(bool loadLines);  // False for results that are not files on disk
     void setSearchOptions(SearchOptions searchOptions);
     void traverseKeywords(bool backward);
     void traverseAndReplaceKeywords(bool backward);
@@ -47,8 +50,6 @@ private:
     bool m_unsavedChanges;
     QMap<QString, QString> m_modifiedFiles;
     void cleanupResources();
-    QStandardItemModel* m_resultModel;
+    SystemSearchResultModel* m_resultModel;
     SearchOptions m_searchOptions;
-    QStandardItemModel* m_treeModel;
-    QString removeHtmlTags(const QString& text);
 };
@@ -0,0 +1,285 @@
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include "systemsearchresultmodel.h"
+
+SystemSearchResultModel::SystemSearchResultModel(QObject* parent)
+    : QAbstractItemModel(parent), m_lineCache(kLineCacheCost) {
+}
+
+void SystemSearchResultModel::setLoadLinesFromFiles(bool loadLines) {
+    m_loadLines = loadLines;
+}
+
+void SystemSearchResultModel::addResult(const FileSearchResults& result) {
+    addResults({result});
+}
+
+// One row insertion for the whole batch
+void SystemSearchResultModel::addResults(const QVector<FileSearchResults>& results) {
+    const int count = int(std::count_if(results.cbegin(), results.cend(),
+                                        [](const FileSearchResults& result) { return !result.lines.isEmpty(); }));
+    if (count == 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), int(m_files.size()), int(m_files.size()) + count - 1);
+    for (const FileSearchResults& result : results) {
+        if (!result.lines.isEmpty()) {
+            appendResult(result);
+        }
+    }
+    endInsertRows();
+}
+
+void SystemSearchResultModel::appendResult(const FileSearchResults& result) {
+    const int fileIndex = int(m_files.size());
+    File file{result.filePath, result.matchCount, int(m_lines.size()), 0, QString()};
+
+    // Which keywords of a keyword list search matched, and how often
+    if (!result.keywordCounts.isEmpty()) {
+        QStringList counts;
+        for (auto it = result.keywordCounts.cbegin(); it != result.keywordCounts.cend(); ++it) {
+            counts.append(QString("%1: %2").arg(it.key()).arg(it.value()));
+        }
+        file.toolTip = counts.join('\n');
+    }
+
+    // One row per matching line, its ranges appended to the shared array
+    for (qsizetype i = 0; i < result.lines.size(); ++i) {
+        const FileSearchResults::Line& matched = result.lines.at(i);
+        Line line{fileIndex, matched.lineNumber, int(m_ranges.size()), matched.rangeCount, matched.rangeCount};
+        for (int k = matched.firstRange; k < matched.firstRange + matched.rangeCount; ++k) {
+            m_ranges.append({result.ranges.at(k).first, result.ranges.at(k).second});
+        }
+
+        if (!m_loadLines && i < result.lineTexts.size()) {
+            m_texts.insert(int(m_lines.size()), result.lineTexts.at(i));
+        }
+        m_lines.append(line);
+        ++file.lineCount;
+    }
+    m_files.append(file);
+}
+
+void SystemSearchResultModel::clear() {
+    beginResetModel();
+    m_files.clear();
+    m_lines.clear();
+    m_ranges.clear();
+    m_texts.clear();
+    m_lineCache.clear();
+    m_currentLine = -1;
+    endResetModel();
+}
+
+int SystemSearchResultModel::lineCount() const {
+    return int(m_lines.size());
+}
+
+int SystemSearchResultModel::lineIndex(const QModelIndex& index) const {
+    if (!index.isValid() || index.internalId() == 0) {
+        return -1;
+    }
+    return m_files.at(int(index.internalId() - 1)).firstLine + index.row();
+}
+
+QModelIndex SystemSearchResultModel::indexOfLine(int line) const {
+    if (line < 0 || line >= m_lines.size()) {
+        return QModelIndex();
+    }
+    const int file = m_lines.at(line).file;
+    return createIndex(line - m_files.at(file).firstLine, 0, quintptr(file + 1));
+}
+
+QString SystemSearchResultModel::filePathOfLine(int line) const {
+    return m_files.at(m_lines.at(line).file).path;
+}
+
+int SystemSearchResultModel::lineNumber(int line) const {
+    return m_lines.at(line).lineNumber;
+}
+
+QString SystemSearchResultModel::lineText(int line) const {
+    const auto text = m_texts.constFind(line);
+    if (text != m_texts.constEnd()) {
+        return text.value();
+    }
+    if (!m_loadLines) {
+        return QString();
+    }
+
+    const int file = m_lines.at(line).file;
+    const int offset = line - m_files.at(file).firstLine;
+    if (const QVector<QString>* cached = m_lineCache.object(file)) {
+        return cached->at(offset);
+    }
+
+    QVector<QString> texts = loadLines(file);
+    const QString result = texts.at(offset);
+    qsizetype cost = 1;
+    for (const QString& loaded : std::as_const(texts)) {
+        cost += loaded.size();
+    }
+    // A file over the limit still stays until the next file is loaded
+    m_lineCache.insert(file, new QVector<QString>(std::move(texts)), qMin<qsizetype>(cost, kLineCacheCost));
+    return result;
+}
+
+void SystemSearchResultModel::setLineText(int line, const QString& text) {
+    m_texts.insert(line, text);
+    m_lines[line].rangeCount = 0;  // The matches were replaced
+    const QModelIndex index = indexOfLine(line);
+    emit dataChanged(index, index.siblingAtColumn(1));
+}
+
+void SystemSearchResultModel::setCurrentLine(int line) {
+    const int previous = m_currentLine;
+    m_currentLine = line;
+    if (previous >= 0 && previous < m_lines.size()) {
+        const QModelIndex index = indexOfLine(previous);
+        emit dataChanged(index, index, {CurrentLineRole});
+    }
+    if (line >= 0 && line < m_lines.size()) {
+        const QModelIndex index = indexOfLine(line);
+        emit dataChanged(index, index, {CurrentLineRole});
+    }
+}
+
+// Line texts of one file's rows, read in one pass the way FileSearchWorker split them
+QVector<QString> SystemSearchResultModel::loadLines(int file) const {
+    const File& entry = m_files.at(file);
+    QVector<QString> texts(entry.lineCount);
+
+    QFile input(entry.path);
+    if (!input.open(QIODevice::ReadOnly) || input.size() == 0) {
+        return texts;
+    }
+    const qint64 size = input.size();
+    const uchar* mapped = input.map(0, size);
+    QByteArray buffer;
+    if (!mapped) {
+        buffer = input.readAll();
+    }
+    const QByteArrayView bytes(mapped ? reinterpret_cast<const char*>(mapped) : buffer.constData(),
+                               mapped ? size : buffer.size());
+
+    int k = 0;
+    if (bytes.startsWith("\xFF\xFE") || bytes.startsWith("\xFE\xFF")
+        || bytes.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4))) {
+        input.seek(0);
+        QTextStream in(&input);
+        for (int number = 0; k < entry.lineCount && !in.atEnd(); ++number) {
+            const QString line = in.readLine();
+            if (m_lines.at(entry.firstLine + k).lineNumber == number) {
+                texts[k++] = line;
+            }
+        }
+        return texts;
+    }
+
+    const char* data = bytes.data();
+    const qint64 end = bytes.size();
+    qint64 position = bytes.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+    int number = 0;
+    for (; k < entry.lineCount; ++k) {
+        const int wanted = m_lines.at(entry.firstLine + k).lineNumber;
+        while (number < wanted && position <= end) {
+            const char* newline = static_cast<const char*>(memchr(data + position, '\n', size_t(end - position)));
+            position = newline ? newline - data + 1 : end + 1;
+            ++number;
+        }
+        if (position > end) break;  // The file is shorter than when it was searched
+
+        const char* newline = static_cast<const char*>(memchr(data + position, '\n', size_t(end - position)));
+        qint64 lineEnd = newline ? newline - data : end;
+        if (lineEnd > position && data[lineEnd - 1] == '\r') --lineEnd;
+        texts[k] = QString::fromUtf8(data + position, lineEnd - position);
+    }
+    return texts;
+}
+
+QModelIndex SystemSearchResultModel::index(int row, int column, const QModelIndex& parent) const {
+    if (row < 0 || column < 0 || column >= 2) {
+        return QModelIndex();
+    }
+    if (!parent.isValid()) {
+        return row < m_files.size() ? createIndex(row, column, quintptr(0)) : QModelIndex();
+    }
+    if (parent.internalId() != 0 || row >= m_files.at(parent.row()).lineCount) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex SystemSearchResultModel::parent(const QModelIndex& child) const {
+    if (!child.isValid() || child.internalId() == 0) {
+        return QModelIndex();
+    }
+    return createIndex(int(child.internalId() - 1), 0, quintptr(0));
+}
+
+int SystemSearchResultModel::rowCount(const QModelIndex& parent) const {
+    if (!parent.isValid()) {
+        return int(m_files.size());
+    }
+    if (parent.internalId() == 0 && parent.column() == 0) {
+        return m_files.at(parent.row()).lineCount;
+    }
+    return 0;
+}
+
+int SystemSearchResultModel::columnCount(const QModelIndex&) const {
+    return 2;
+}
+
+QVariant SystemSearchResultModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    if (index.internalId() == 0) {
+        const File& file = m_files.at(index.row());
+        if (role == Qt::DisplayRole) {
+            return index.column() == 0 ? QVariant(file.path) : QVariant(QString::number(file.matchCount));
+        }
+        if (role == Qt::ToolTipRole && !file.toolTip.isEmpty()) {
+            return file.toolTip;
+        }
+        return QVariant();
+    }
+
+    const int line = lineIndex(index);
+    const Line& entry = m_lines.at(line);
+    switch (role) {
+    case Qt::DisplayRole:
+        return index.column() == 0 ? QVariant(lineText(line)) : QVariant(QString::number(entry.matches));
+    case LineNumberRole:
+        return entry.lineNumber + 1;
+    case MatchRangesRole: {
+        if (index.column() != 0) return QVariant();
+        QList<int> ranges;
+        ranges.reserve(entry.rangeCount * 2);
+        for (int i = entry.firstRange; i < entry.firstRange + entry.rangeCount; ++i) {
+            ranges << m_ranges.at(i).start << m_ranges.at(i).length;
+        }
+        return QVariant::fromValue(ranges);
+    }
+    case CurrentLineRole:
+        return line == m_currentLine;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SystemSearchResultModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        return section == 0 ? tr("File Path") : tr("Matches");
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags SystemSearchResultModel::flags(const QModelIndex& index) const {
+    return index.isValid() ? Qt::ItemIsEnabled | Qt::ItemIsSelectable : Qt::NoItemFlags;
+}
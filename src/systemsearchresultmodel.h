@@ -0,0 +1,86 @@
+#pragma once
+
+#include <QAbstractItemModel>
+#include <QCache>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "search/searchoptions.h"
+
+// Results of a directory or all-tabs search as a two level tree: files, then one row per
+// matching line. A line is stored as its number and the ranges of its matches, and the
+// text is read back from the file when a row is shown, so millions of hits take a few
+// dozen bytes each rather than a QStandardItem and an HTML string.
+class SystemSearchResultModel : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        LineNumberRole = Qt::UserRole,      // 1-based, on line rows
+        MatchRangesRole = Qt::UserRole + 2, // QList<int> of start, length pairs in the line text
+        CurrentLineRole = Qt::UserRole + 3  // The line traverseKeywords() stopped at
+    };
+
+    explicit SystemSearchResultModel(QObject* parent = nullptr);
+
+    // With `loadLines` false the text of every line is kept, for results that do not come
+    // from files on disk (open tabs)
+    void setLoadLinesFromFiles(bool loadLines);
+
+    // With line loading off, the text comes from `result.lineTexts`
+    void addResult(const FileSearchResults& result);
+    void addResults(const QVector<FileSearchResults>& results);
+    void clear();
+
+    int lineCount() const;                      // Line rows over all files
+    int lineIndex(const QModelIndex& index) const;
+    QModelIndex indexOfLine(int line) const;
+    QString filePathOfLine(int line) const;
+    int lineNumber(int line) const;             // 0-based line in the file
+    QString lineText(int line) const;
+    void setLineText(int line, const QString& text);
+    void setCurrentLine(int line);
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+private:
+    struct File {
+        QString path;
+        int matchCount;
+        int firstLine;      // Into m_lines
+        int lineCount;
+        QString toolTip;    // Keyword counts of a keyword list search
+    };
+
+    struct Line {
+        int file;
+        int lineNumber;
+        int firstRange;     // Into m_ranges
+        int rangeCount;
+        int matches;
+    };
+
+    struct Range {
+        int start;
+        int length;
+    };
+
+    void appendResult(const FileSearchResults& result);
+    QVector<QString> loadLines(int file) const;
+
+    static constexpr int kLineCacheCost = 4 * 1024 * 1024;  // Characters of loaded line text
+
+    QVector<File> m_files;
+    QVector<Line> m_lines;
+    QVector<Range> m_ranges;
+    QHash<int, QString> m_texts;        // Lines kept in memory: not loaded from files, or edited
+    mutable QCache<int, QVector<QString>> m_lineCache;
+    bool m_loadLines = true;
+    int m_currentLine = -1;
+};
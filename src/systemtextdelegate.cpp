@@ -1,11 +1,11 @@
+#include <QApplication>
 #include <QPainter>
 #include <QFontMetrics>
-#include <QTextDocument>
-#include <QStyledItemDelegate>
+#include <QStyle>
 #include <QStyleOptionViewItem>
 #include <QModelIndex>
-#include <QStyleOptionViewItem>
 #include "systemtextdelegate.h"
+#include "systemsearchresultmodel.h"
 
 SystemTextDelegate::SystemTextDelegate(QObject *parent)
     : QStyledItemDelegate(parent) {}
@@ -13,73 +13,46 @@ SystemTextDelegate::SystemTextDelegate(QObject *parent)
 void SystemTextDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
     if (!index.isValid()) return;
 
-    // Retrieve content from the model
-    QString content = index.data(Qt::DisplayRole).toString();
-    QString keyword = index.data(Qt::UserRole).toString();
-
-    // Highlight keywords dynamically if plain text
-    if (!content.contains("<span") && !keyword.isEmpty()) {
-        content.replace(
-            keyword,
-            QString("<span style='background-color: yellow;'>%1</span>").arg(keyword),
-            Qt::CaseInsensitive);
-    }
-
-    painter->save();
-
-    // Clip the painter to the item's rectangle to prevent overlapping
-    QRect rect = option.rect;
-    painter->setClipRect(rect);
-
-    // Handle selection background
-    if (option.state & QStyle::State_Selected) {
-        painter->fillRect(rect, option.palette.highlight());
+    const QVariant ranges = index.data(SystemSearchResultModel::MatchRangesRole);
+    if (!ranges.isValid()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
     }
 
-    if (content.contains("<span")) {
-        // Render HTML using QTextDocument
-        QTextDocument doc;
-        doc.setHtml(content);
-        doc.setTextWidth(rect.width());
+    // Let the style draw the background, selection and focus, then draw the text ourselves
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    const QString text = opt.text;
+    opt.text.clear();
 
-        // Translate the painter to align with the item's rectangle
-        painter->translate(rect.topLeft());
-        doc.drawContents(painter);
-    } else {
-        // Elide plain text if it exceeds the available space
-        QFontMetrics metrics(option.font);
-        QString elidedText = metrics.elidedText(content, Qt::ElideRight, rect.width());
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+    const QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget);
 
-        // Set text color for selected state
-        if (option.state & QStyle::State_Selected) {
-            painter->setPen(option.palette.highlightedText().color());
-        } else {
-            painter->setPen(option.palette.text().color());
-        }
-
-        // Draw the elided text
-        painter->drawText(rect, Qt::AlignVCenter | Qt::AlignLeft, elidedText);
+    painter->save();
+    painter->setClipRect(textRect);
+    painter->setFont(opt.font);
+    painter->setPen(opt.state & QStyle::State_Selected ? opt.palette.highlightedText().color()
+                                                       : opt.palette.text().color());
+    painter->drawText(textRect, Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine, text);
+
+    // Matches on yellow, or cyan on the line Find Next/Previous stopped at
+    const QFontMetrics metrics(opt.font);
+    const QColor background = index.data(SystemSearchResultModel::CurrentLineRole).toBool() ? Qt::cyan : Qt::yellow;
+    const QList<int> spans = ranges.value<QList<int>>();
+    for (qsizetype i = 0; i + 1 < spans.size(); i += 2) {
+        const qsizetype start = qBound<qsizetype>(0, spans.at(i), text.size());
+        const qsizetype length = qBound<qsizetype>(0, spans.at(i + 1), text.size() - start);
+        if (length == 0) continue;
+
+        const QString match = text.mid(start, length);
+        const int x = textRect.left() + metrics.horizontalAdvance(text.left(start));
+        const QRect matchRect(x, textRect.top(), metrics.horizontalAdvance(match), textRect.height());
+        painter->fillRect(matchRect, background);
+        painter->setPen(Qt::black);
+        painter->drawText(matchRect, Qt::AlignVCenter | Qt::AlignLeft | Qt::TextSingleLine, match);
     }
 
     painter->restore();
 }
-
-QSize SystemTextDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const {
-    if (!index.isValid()) return QStyledItemDelegate::sizeHint(option, index);
-
-    // Retrieve content from the model
-    QString content = index.data(Qt::DisplayRole).toString();
-
-    if (content.contains("<span")) {
-        // Calculate height dynamically for HTML content
-        QTextDocument doc;
-        doc.setHtml(content);
-        doc.setTextWidth(option.rect.width());
-        return QSize(option.rect.width(), doc.size().height());
-    } else {
-        // Fallback for plain text
-        QFontMetrics metrics(option.font);
-        int height = metrics.height();
-        return QSize(option.rect.width(), height);
-    }
-}
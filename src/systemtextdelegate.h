@@ -1,8 +1,9 @@
 #pragma once
 
 #include <QStyledItemDelegate>
-#include <QTextDocument>
 
+// Draws result lines with their matches on a colored background, straight from the
+// ranges in SystemSearchResultModel::MatchRangesRole; other cells paint as usual.
 class SystemTextDelegate : public QStyledItemDelegate {
     Q_OBJECT
 
@@ -10,5 +11,4 @@ public:
     explicit SystemTextDelegate(QObject *parent = nullptr);
 
     void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
-    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
 };